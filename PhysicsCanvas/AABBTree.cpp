@@ -0,0 +1,291 @@
+#include "AABBTree.h"
+
+using namespace PhysicsCanvas;
+
+int AABBTree::AllocateNode() {
+	int node;
+	if (freeList != NULL_NODE) {
+		node = freeList;
+		freeList = nodes[node].parent;
+	}
+	else {
+		node = (int)nodes.size();
+		nodes.push_back(Node());
+	}
+	nodes[node].parent = NULL_NODE;
+	nodes[node].child1 = NULL_NODE;
+	nodes[node].child2 = NULL_NODE;
+	nodes[node].userData = -1;
+	nodes[node].height = 0;
+	return node;
+}
+
+void AABBTree::FreeNode(int node) {
+	nodes[node].parent = freeList;
+	nodes[node].height = -1;
+	freeList = node;
+}
+
+void AABBTree::Clear() {
+	nodes.clear();
+	root = NULL_NODE;
+	freeList = NULL_NODE;
+}
+
+int AABBTree::CreateProxy(XMFLOAT3 minP, XMFLOAT3 maxP, int userData) {
+	int proxy = AllocateNode();
+	nodes[proxy].minP = XMFLOAT3(minP.x - margin, minP.y - margin, minP.z - margin);
+	nodes[proxy].maxP = XMFLOAT3(maxP.x + margin, maxP.y + margin, maxP.z + margin);
+	nodes[proxy].userData = userData;
+	InsertLeaf(proxy);
+	return proxy;
+}
+
+void AABBTree::DestroyProxy(int proxy) {
+	RemoveLeaf(proxy);
+	FreeNode(proxy);
+}
+
+bool AABBTree::MoveProxy(int proxy, XMFLOAT3 minP, XMFLOAT3 maxP) {
+	if (Contains(nodes[proxy], minP, maxP))
+		return false;
+
+	RemoveLeaf(proxy);
+	nodes[proxy].minP = XMFLOAT3(minP.x - margin, minP.y - margin, minP.z - margin);
+	nodes[proxy].maxP = XMFLOAT3(maxP.x + margin, maxP.y + margin, maxP.z + margin);
+	InsertLeaf(proxy);
+	return true;
+}
+
+void AABBTree::InsertLeaf(int leaf) {
+	if (root == NULL_NODE) {
+		root = leaf;
+		nodes[root].parent = NULL_NODE;
+		return;
+	}
+
+	//walk down to the cheapest sibling, where cost is the surface area the tree gains by putting the leaf there
+	Node& leafNode = nodes[leaf];
+	int index = root;
+	while (!nodes[index].IsLeaf()) {
+		int child1 = nodes[index].child1;
+		int child2 = nodes[index].child2;
+
+		XMFLOAT3 cMin, cMax;
+		Combine(nodes[index], leafNode, cMin, cMax);
+		float area = SurfaceArea(nodes[index].minP, nodes[index].maxP);
+		float combinedArea = SurfaceArea(cMin, cMax);
+
+		//cost of making a new parent for this node and the leaf
+		float cost = 2.0f * combinedArea;
+		//minimum cost of pushing the leaf further down the tree
+		float inheritanceCost = 2.0f * (combinedArea - area);
+
+		float cost1, cost2;
+		Combine(nodes[child1], leafNode, cMin, cMax);
+		cost1 = SurfaceArea(cMin, cMax) + inheritanceCost;
+		if (!nodes[child1].IsLeaf())
+			cost1 -= SurfaceArea(nodes[child1].minP, nodes[child1].maxP);
+		Combine(nodes[child2], leafNode, cMin, cMax);
+		cost2 = SurfaceArea(cMin, cMax) + inheritanceCost;
+		if (!nodes[child2].IsLeaf())
+			cost2 -= SurfaceArea(nodes[child2].minP, nodes[child2].maxP);
+
+		if (cost < cost1 && cost < cost2)
+			break;
+		index = cost1 < cost2 ? child1 : child2;
+	}
+	int sibling = index;
+
+	//make a new parent for the sibling and the leaf. AllocateNode can grow the vector, so no references are held across it
+	int oldParent = nodes[sibling].parent;
+	int newParent = AllocateNode();
+	nodes[newParent].parent = oldParent;
+	Combine(nodes[sibling], nodes[leaf], nodes[newParent].minP, nodes[newParent].maxP);
+	nodes[newParent].height = nodes[sibling].height + 1;
+	nodes[newParent].child1 = sibling;
+	nodes[newParent].child2 = leaf;
+	nodes[sibling].parent = newParent;
+	nodes[leaf].parent = newParent;
+
+	if (oldParent != NULL_NODE) {
+		if (nodes[oldParent].child1 == sibling)
+			nodes[oldParent].child1 = newParent;
+		else
+			nodes[oldParent].child2 = newParent;
+	}
+	else {
+		root = newParent;
+	}
+
+	Refit(nodes[leaf].parent);
+}
+
+void AABBTree::RemoveLeaf(int leaf) {
+	if (leaf == root) {
+		root = NULL_NODE;
+		return;
+	}
+
+	int parent = nodes[leaf].parent;
+	int grandParent = nodes[parent].parent;
+	int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+	if (grandParent != NULL_NODE) {
+		//the sibling takes the parent's place
+		if (nodes[grandParent].child1 == parent)
+			nodes[grandParent].child1 = sibling;
+		else
+			nodes[grandParent].child2 = sibling;
+		nodes[sibling].parent = grandParent;
+		FreeNode(parent);
+		Refit(grandParent);
+	}
+	else {
+		root = sibling;
+		nodes[sibling].parent = NULL_NODE;
+		FreeNode(parent);
+	}
+}
+
+void AABBTree::Refit(int index) {
+	while (index != NULL_NODE) {
+		index = Balance(index);
+
+		int child1 = nodes[index].child1;
+		int child2 = nodes[index].child2;
+		nodes[index].height = 1 + (nodes[child1].height > nodes[child2].height ? nodes[child1].height : nodes[child2].height);
+		Combine(nodes[child1], nodes[child2], nodes[index].minP, nodes[index].maxP);
+
+		index = nodes[index].parent;
+	}
+}
+
+int AABBTree::Balance(int iA) {
+	Node& A = nodes[iA];
+	if (A.IsLeaf() || A.height < 2)
+		return iA;
+
+	int iB = A.child1;
+	int iC = A.child2;
+	int balance = nodes[iC].height - nodes[iB].height;
+
+	//rotate whichever child is too tall up into A's place
+	if (balance > 1 || balance < -1) {
+		int iUp = balance > 1 ? iC : iB;
+		int iOther = balance > 1 ? iB : iC;
+		Node& Up = nodes[iUp];
+		int iF = Up.child1;
+		int iG = Up.child2;
+
+		//Up becomes the parent of A
+		Up.child1 = iA;
+		Up.parent = A.parent;
+		A.parent = iUp;
+
+		if (Up.parent != NULL_NODE) {
+			if (nodes[Up.parent].child1 == iA)
+				nodes[Up.parent].child1 = iUp;
+			else
+				nodes[Up.parent].child2 = iUp;
+		}
+		else {
+			root = iUp;
+		}
+
+		//the taller of Up's children stays with Up, the other goes to A
+		int iKeep = nodes[iF].height > nodes[iG].height ? iF : iG;
+		int iGive = iKeep == iF ? iG : iF;
+		Up.child2 = iKeep;
+		if (balance > 1)
+			A.child2 = iGive;
+		else
+			A.child1 = iGive;
+		nodes[iGive].parent = iA;
+
+		Combine(nodes[iOther], nodes[iGive], A.minP, A.maxP);
+		Combine(A, nodes[iKeep], Up.minP, Up.maxP);
+		A.height = 1 + (nodes[iOther].height > nodes[iGive].height ? nodes[iOther].height : nodes[iGive].height);
+		Up.height = 1 + (A.height > nodes[iKeep].height ? A.height : nodes[iKeep].height);
+		return iUp;
+	}
+	return iA;
+}
+
+void AABBTree::QueryBox(XMFLOAT3 minP, XMFLOAT3 maxP, std::vector<int>& results) {
+	if (root == NULL_NODE)
+		return;
+	stack.clear();
+	stack.push_back(root);
+	while (!stack.empty()) {
+		int index = stack.back();
+		stack.pop_back();
+		Node& n = nodes[index];
+		if (!BoxesOverlap(n.minP, n.maxP, minP, maxP))
+			continue;
+		if (n.IsLeaf()) {
+			results.push_back(n.userData);
+		}
+		else {
+			stack.push_back(n.child1);
+			stack.push_back(n.child2);
+		}
+	}
+}
+
+void AABBTree::QueryPoint(XMFLOAT3 point, std::vector<int>& results) {
+	QueryBox(point, point, results);
+}
+
+void AABBTree::QueryRay(XMFLOAT3 origin, XMFLOAT3 dir, float maxDist, std::vector<int>& results) {
+	if (root == NULL_NODE)
+		return;
+	stack.clear();
+	stack.push_back(root);
+	float tEnter;
+	while (!stack.empty()) {
+		int index = stack.back();
+		stack.pop_back();
+		Node& n = nodes[index];
+		if (!PhysMaths::RayHitsAABB(origin, dir, n.minP, n.maxP, maxDist, tEnter))
+			continue;
+		if (n.IsLeaf()) {
+			results.push_back(n.userData);
+		}
+		else {
+			stack.push_back(n.child1);
+			stack.push_back(n.child2);
+		}
+	}
+}
+
+void AABBTree::QueryPairs(std::vector<std::pair<int, int>>& pairs) {
+	if (root == NULL_NODE)
+		return;
+	//query the tree with every leaf, keeping each pair only from the side with the smaller userData
+	for (int leaf = 0; leaf < (int)nodes.size(); leaf++) {
+		if (nodes[leaf].height != 0)
+			continue;
+		XMFLOAT3 minP = nodes[leaf].minP;
+		XMFLOAT3 maxP = nodes[leaf].maxP;
+		int userData = nodes[leaf].userData;
+
+		stack.clear();
+		stack.push_back(root);
+		while (!stack.empty()) {
+			int index = stack.back();
+			stack.pop_back();
+			Node& n = nodes[index];
+			if (!BoxesOverlap(n.minP, n.maxP, minP, maxP))
+				continue;
+			if (n.IsLeaf()) {
+				if (n.userData > userData)
+					pairs.push_back(std::pair<int, int>(userData, n.userData));
+			}
+			else {
+				stack.push_back(n.child1);
+				stack.push_back(n.child2);
+			}
+		}
+	}
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include "pch.h"
+#include "PhysMaths.h"
+#include <vector>
+
+using namespace DirectX;
+
+namespace PhysicsCanvas {
+	//Dynamic bounding volume hierarchy. Each leaf stores a "fat" AABB, the real bounds grown by a margin,
+	//so a body that only moves a little each step stays inside its leaf and the tree doesn't have to change.
+	//Leaves are placed using the surface area heuristic and the tree is kept balanced with rotations, so queries are O(log n).
+	class AABBTree {
+	public:
+		static const int NULL_NODE = -1;
+
+		AABBTree(float margin_ = 0.1f) : root(NULL_NODE), freeList(NULL_NODE), margin(margin_) {}
+
+		//returns the id of the new leaf, userData is handed back by the queries
+		int CreateProxy(XMFLOAT3 minP, XMFLOAT3 maxP, int userData);
+
+		void DestroyProxy(int proxy);
+
+		//returns true if the leaf had to be reinserted because the bounds left its fat AABB
+		bool MoveProxy(int proxy, XMFLOAT3 minP, XMFLOAT3 maxP);
+
+		int GetUserData(int proxy) { return nodes[proxy].userData; }
+
+		void Clear();
+
+		//all of these append the userData of each leaf whose fat AABB passes the test
+		void QueryBox(XMFLOAT3 minP, XMFLOAT3 maxP, std::vector<int>& results);
+
+		void QueryPoint(XMFLOAT3 point, std::vector<int>& results);
+
+		void QueryRay(XMFLOAT3 origin, XMFLOAT3 dir, float maxDist, std::vector<int>& results);
+
+		//every pair of leaves whose fat AABBs overlap, once each, as (smaller userData, larger userData)
+		void QueryPairs(std::vector<std::pair<int, int>>& pairs);
+	private:
+		struct Node {
+			XMFLOAT3 minP;
+			XMFLOAT3 maxP;
+			int parent;		//doubles as the next link when the node is on the free list
+			int child1;
+			int child2;
+			int userData;
+			int height;		//0 for leaves, -1 for free nodes
+
+			bool IsLeaf() const { return child1 == NULL_NODE; }
+		};
+
+		int AllocateNode();
+		void FreeNode(int node);
+
+		void InsertLeaf(int leaf);
+		void RemoveLeaf(int leaf);
+
+		//rotates the subtree at a up a level if it is unbalanced, returns the new root of the subtree
+		int Balance(int a);
+
+		//walks from node to the root, refitting the boxes and rebalancing on the way
+		void Refit(int node);
+
+		static float SurfaceArea(XMFLOAT3 minP, XMFLOAT3 maxP) {
+			XMFLOAT3 d(maxP.x - minP.x, maxP.y - minP.y, maxP.z - minP.z);
+			return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+		}
+
+		static void Combine(const Node& a, const Node& b, XMFLOAT3& minP, XMFLOAT3& maxP) {
+			minP = XMFLOAT3(a.minP.x < b.minP.x ? a.minP.x : b.minP.x, a.minP.y < b.minP.y ? a.minP.y : b.minP.y, a.minP.z < b.minP.z ? a.minP.z : b.minP.z);
+			maxP = XMFLOAT3(a.maxP.x > b.maxP.x ? a.maxP.x : b.maxP.x, a.maxP.y > b.maxP.y ? a.maxP.y : b.maxP.y, a.maxP.z > b.maxP.z ? a.maxP.z : b.maxP.z);
+		}
+
+		static bool BoxesOverlap(XMFLOAT3 min1, XMFLOAT3 max1, XMFLOAT3 min2, XMFLOAT3 max2) {
+			return min1.x <= max2.x && max1.x >= min2.x
+				&& min1.y <= max2.y && max1.y >= min2.y
+				&& min1.z <= max2.z && max1.z >= min2.z;
+		}
+
+		static bool Contains(const Node& n, XMFLOAT3 minP, XMFLOAT3 maxP) {
+			return n.minP.x <= minP.x && n.minP.y <= minP.y && n.minP.z <= minP.z
+				&& n.maxP.x >= maxP.x && n.maxP.y >= maxP.y && n.maxP.z >= maxP.z;
+		}
+
+		std::vector<Node> nodes;
+		int root;
+		int freeList;
+		float margin;
+
+		std::vector<int> stack;		//kept between queries so they don't allocate
+	};
+}
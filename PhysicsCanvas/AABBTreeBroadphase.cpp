@@ -0,0 +1,53 @@
+#include "AABBTreeBroadphase.h"
+#include <algorithm>
+
+using namespace PhysicsCanvas;
+
+void AABBTreeBroadphase::Update(std::list<std::shared_ptr<PhysicsBody>>& bodies) {
+	bool unchanged = SyncProxies(bodies);
+	RefreshBounds();
+	if (!unchanged) {
+		tree.Clear();
+		leaves.clear();
+		for (int i = 0; i < (int)proxies.size(); i++) {
+			leaves.push_back(tree.CreateProxy(proxies[i].minP, proxies[i].maxP, i));
+		}
+	}
+	else {
+		for (int i = 0; i < (int)proxies.size(); i++) {
+			tree.MoveProxy(leaves[i], proxies[i].minP, proxies[i].maxP);
+		}
+	}
+
+	//the tree pairs up fat boxes, so drop the pairs whose real boxes don't touch
+	pairs.clear();
+	tree.QueryPairs(pairs);
+	pairs.erase(std::remove_if(pairs.begin(), pairs.end(), [this](const BodyPair& pair) {
+		return !Overlaps(proxies[pair.first], proxies[pair.second]);
+	}), pairs.end());
+}
+
+void AABBTreeBroadphase::RayQuery(XMFLOAT3 origin, XMFLOAT3 dir, float maxDist, std::vector<int>& hits) {
+	hits.clear();
+	tree.QueryRay(origin, dir, maxDist, hits);
+	float tEnter;
+	hits.erase(std::remove_if(hits.begin(), hits.end(), [&](int i) {
+		return !PhysMaths::RayHitsAABB(origin, dir, proxies[i].minP, proxies[i].maxP, maxDist, tEnter);
+	}), hits.end());
+	std::sort(hits.begin(), hits.end());
+}
+
+void AABBTreeBroadphase::PointQuery(XMFLOAT3 point, std::vector<int>& hits) {
+	BoxQuery(point, point, hits);
+}
+
+void AABBTreeBroadphase::BoxQuery(XMFLOAT3 minP, XMFLOAT3 maxP, std::vector<int>& hits) {
+	hits.clear();
+	tree.QueryBox(minP, maxP, hits);
+	hits.erase(std::remove_if(hits.begin(), hits.end(), [&](int i) {
+		return !(proxies[i].minP.x <= maxP.x && proxies[i].maxP.x >= minP.x
+			&& proxies[i].minP.y <= maxP.y && proxies[i].maxP.y >= minP.y
+			&& proxies[i].minP.z <= maxP.z && proxies[i].maxP.z >= minP.z);
+	}), hits.end());
+	std::sort(hits.begin(), hits.end());
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "pch.h"
+#include "Broadphase.h"
+#include "AABBTree.h"
+
+namespace PhysicsCanvas {
+	//Broadphase backed by a dynamic AABB tree. Leaves are only reinserted when a body leaves its fat AABB,
+	//and the same tree answers the ray, point and box queries used for picking and placing bodies.
+	class AABBTreeBroadphase : public Broadphase {
+	public:
+		void Update(std::list<std::shared_ptr<PhysicsBody>>& bodies) override;
+
+		Type GetType() override { return DynamicTree; }
+
+		void RayQuery(XMFLOAT3 origin, XMFLOAT3 dir, float maxDist, std::vector<int>& hits) override;
+
+		void PointQuery(XMFLOAT3 point, std::vector<int>& hits) override;
+
+		void BoxQuery(XMFLOAT3 minP, XMFLOAT3 maxP, std::vector<int>& hits) override;
+	private:
+		AABBTree tree;
+		std::vector<int> leaves;	//tree leaf for each proxy
+	};
+}
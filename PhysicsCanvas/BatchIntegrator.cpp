@@ -0,0 +1,242 @@
+#include "BatchIntegrator.h"
+#include <cstring>
+
+#if defined(_M_IX86) || defined(_M_X64)
+#define INTEGRATOR_X86
+#define INTEGRATOR_TARGET(isa)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+//GCC and Clang only use the instructions a function is marked for, so each kernel is built for its own, while the rest of
+//the program still runs on any x86 CPU
+#define INTEGRATOR_X86
+#define INTEGRATOR_TARGET(isa) __attribute__((target(isa)))
+#include <cpuid.h>
+#include <immintrin.h>
+#if !defined(__clang__)
+//GCC would otherwise fuse the kernels' multiplies and adds wherever the instructions allow it, as AVX-512 does
+#pragma GCC optimize("fp-contract=off")
+#endif
+#endif
+
+using namespace PhysicsCanvas;
+
+static void AdvanceScalar(const float* accel, float* vel, float* out, const uint8_t* flags, uint8_t mask,
+	size_t begin, size_t end, float dt) {
+	for (size_t i = begin; i < end; i++) {
+		if (!(flags[i] & mask))
+			continue;
+		vel[i] = vel[i] + (accel[i] * dt);
+		out[i] = (vel[i] * dt) + (0.5f * accel[i] * dt * dt);
+	}
+}
+
+#ifdef INTEGRATOR_X86
+//the first body from begin on a width boundary, or end if there isn't one before it
+static size_t AlignUp(size_t begin, size_t end, size_t width) {
+	size_t aligned = (begin + width - 1) / width * width;
+	return aligned < end ? aligned : end;
+}
+
+INTEGRATOR_TARGET("sse2")
+static void AdvanceSSE(const float* accel, float* vel, float* out, const uint8_t* flags, uint8_t mask,
+	size_t begin, size_t end, float dt) {
+	size_t i = AlignUp(begin, end, 4);
+	AdvanceScalar(accel, vel, out, flags, mask, begin, i, dt);
+	__m128 vdt = _mm_set1_ps(dt);
+	__m128 half = _mm_set1_ps(0.5f);
+	__m128i vmask = _mm_set1_epi32(mask);
+	__m128i zero = _mm_setzero_si128();
+	for (; i + 4 <= end; i += 4) {
+		//widen the 4 flag bytes to a lane each, all bits set where the body is to be advanced
+		int32_t packed;
+		memcpy(&packed, flags + i, 4);
+		__m128i lanes = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+		__m128 on = _mm_castsi128_ps(_mm_cmpgt_epi32(_mm_and_si128(lanes, vmask), zero));
+
+		__m128 a = _mm_load_ps(accel + i);
+		__m128 v0 = _mm_load_ps(vel + i);
+		__m128 v = _mm_add_ps(v0, _mm_mul_ps(a, vdt));
+		__m128 s = _mm_add_ps(_mm_mul_ps(v, vdt), _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(half, a), vdt), vdt));
+		_mm_store_ps(vel + i, _mm_or_ps(_mm_and_ps(on, v), _mm_andnot_ps(on, v0)));
+		_mm_store_ps(out + i, _mm_or_ps(_mm_and_ps(on, s), _mm_andnot_ps(on, _mm_load_ps(out + i))));
+	}
+	AdvanceScalar(accel, vel, out, flags, mask, i, end, dt);
+}
+
+INTEGRATOR_TARGET("avx2")
+static void AdvanceAVX2(const float* accel, float* vel, float* out, const uint8_t* flags, uint8_t mask,
+	size_t begin, size_t end, float dt) {
+	size_t i = AlignUp(begin, end, 8);
+	AdvanceScalar(accel, vel, out, flags, mask, begin, i, dt);
+	__m256 vdt = _mm256_set1_ps(dt);
+	__m256 half = _mm256_set1_ps(0.5f);
+	__m256i vmask = _mm256_set1_epi32(mask);
+	__m256i zero = _mm256_setzero_si256();
+	for (; i + 8 <= end; i += 8) {
+		__m256i lanes = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(flags + i)));
+		__m256 on = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_and_si256(lanes, vmask), zero));
+
+		__m256 a = _mm256_load_ps(accel + i);
+		__m256 v0 = _mm256_load_ps(vel + i);
+		__m256 v = _mm256_add_ps(v0, _mm256_mul_ps(a, vdt));
+		__m256 s = _mm256_add_ps(_mm256_mul_ps(v, vdt), _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(half, a), vdt), vdt));
+		_mm256_store_ps(vel + i, _mm256_blendv_ps(v0, v, on));
+		_mm256_store_ps(out + i, _mm256_blendv_ps(_mm256_load_ps(out + i), s, on));
+	}
+	AdvanceScalar(accel, vel, out, flags, mask, i, end, dt);
+}
+
+INTEGRATOR_TARGET("avx512f")
+static void AdvanceAVX512(const float* accel, float* vel, float* out, const uint8_t* flags, uint8_t mask,
+	size_t begin, size_t end, float dt) {
+	size_t i = AlignUp(begin, end, 16);
+	AdvanceScalar(accel, vel, out, flags, mask, begin, i, dt);
+	__m512 vdt = _mm512_set1_ps(dt);
+	__m512 half = _mm512_set1_ps(0.5f);
+	__m512i vmask = _mm512_set1_epi32(mask);
+	for (; i + 16 <= end; i += 16) {
+		//the bodies not being advanced are masked out of the stores, so they don't need blending back in. The flags are widened
+		//with every lane kept, the same as the unmasked widening, which GCC wrongly warns leaves lanes uninitialised
+		__m512i lanes = _mm512_maskz_cvtepu8_epi32((__mmask16)0xFFFF, _mm_loadu_si128((const __m128i*)(flags + i)));
+		__mmask16 on = _mm512_test_epi32_mask(lanes, vmask);
+
+		__m512 a = _mm512_load_ps(accel + i);
+		__m512 v = _mm512_add_ps(_mm512_load_ps(vel + i), _mm512_mul_ps(a, vdt));
+		__m512 s = _mm512_add_ps(_mm512_mul_ps(v, vdt), _mm512_mul_ps(_mm512_mul_ps(_mm512_mul_ps(half, a), vdt), vdt));
+		_mm512_mask_store_ps(vel + i, on, v);
+		_mm512_mask_store_ps(out + i, on, s);
+	}
+	AdvanceScalar(accel, vel, out, flags, mask, i, end, dt);
+}
+
+//info is eax, ebx, ecx and edx for the leaf, all 0 if the CPU doesn't have it
+static void Cpuid(int info[4], int leaf, int subleaf) {
+#ifdef _MSC_VER
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+	info[0] = info[1] = info[2] = info[3] = 0;
+	if (leaf <= maxLeaf)
+		__cpuidex(info, leaf, subleaf);
+#else
+	unsigned int regs[4] = { 0, 0, 0, 0 };
+	__get_cpuid_count(leaf, subleaf, &regs[0], &regs[1], &regs[2], &regs[3]);
+	for (int r = 0; r < 4; r++)
+		info[r] = (int)regs[r];
+#endif
+}
+
+//which registers the OS saves between threads. Only to be asked if the CPU has OSXSAVE
+static unsigned long long Xcr0() {
+#ifdef _MSC_VER
+	return _xgetbv(0);
+#else
+	unsigned int low, high;
+	__asm__ volatile ("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+	return ((unsigned long long)high << 32) | low;
+#endif
+}
+#endif
+
+//asks the CPU, and the OS for whether it saves the wider registers between threads
+static bool CpuSupports(BatchIntegrator::Kernel kernel) {
+#ifdef INTEGRATOR_X86
+	int info[4];
+	Cpuid(info, 1, 0);
+	bool sse2 = (info[3] & (1 << 26)) != 0;
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	unsigned long long xcr0 = osxsave ? Xcr0() : 0;
+	Cpuid(info, 7, 0);
+	int features7 = info[1];
+	switch (kernel) {
+	case BatchIntegrator::SSE:
+		return sse2;
+	case BatchIntegrator::AVX2:
+		return avx && (xcr0 & 0x6) == 0x6 && (features7 & (1 << 5)) != 0;
+	case BatchIntegrator::AVX512:
+		return (xcr0 & 0xE6) == 0xE6 && (features7 & (1 << 16)) != 0;
+	default:
+		break;
+	}
+#endif
+	return kernel == BatchIntegrator::Scalar;
+}
+
+static BatchIntegrator::Kernel& CurrentKernel() {
+	static BatchIntegrator::Kernel kernel = BatchIntegrator::Best();
+	return kernel;
+}
+
+bool BatchIntegrator::Supported(Kernel kernel) {
+	static bool supported[KERNEL_COUNT] = {
+		CpuSupports(Scalar), CpuSupports(SSE), CpuSupports(AVX2), CpuSupports(AVX512)
+	};
+	return kernel >= 0 && kernel < KERNEL_COUNT && supported[kernel];
+}
+
+BatchIntegrator::Kernel BatchIntegrator::Best() {
+	for (int k = KERNEL_COUNT - 1; k > Scalar; k--) {
+		if (Supported((Kernel)k))
+			return (Kernel)k;
+	}
+	return Scalar;
+}
+
+BatchIntegrator::Kernel BatchIntegrator::GetKernel() {
+	return CurrentKernel();
+}
+
+void BatchIntegrator::SetKernel(Kernel kernel) {
+	CurrentKernel() = Supported(kernel) ? kernel : Best();
+}
+
+const char* BatchIntegrator::Name(Kernel kernel) {
+	switch (kernel) {
+	case SSE:
+		return "sse";
+	case AVX2:
+		return "avx2";
+	case AVX512:
+		return "avx512";
+	default:
+		return "scalar";
+	}
+}
+
+int BatchIntegrator::Width(Kernel kernel) {
+	switch (kernel) {
+	case SSE:
+		return 4;
+	case AVX2:
+		return 8;
+	case AVX512:
+		return 16;
+	default:
+		return 1;
+	}
+}
+
+void BatchIntegrator::Advance(const float* accel, float* vel, float* out, const uint8_t* flags, uint8_t mask,
+	size_t begin, size_t end, float dt) {
+	Advance(CurrentKernel(), accel, vel, out, flags, mask, begin, end, dt);
+}
+
+void BatchIntegrator::Advance(Kernel kernel, const float* accel, float* vel, float* out, const uint8_t* flags, uint8_t mask,
+	size_t begin, size_t end, float dt) {
+	switch (kernel) {
+#ifdef INTEGRATOR_X86
+	case SSE:
+		AdvanceSSE(accel, vel, out, flags, mask, begin, end, dt);
+		break;
+	case AVX2:
+		AdvanceAVX2(accel, vel, out, flags, mask, begin, end, dt);
+		break;
+	case AVX512:
+		AdvanceAVX512(accel, vel, out, flags, mask, begin, end, dt);
+		break;
+#endif
+	default:
+		AdvanceScalar(accel, vel, out, flags, mask, begin, end, dt);
+		break;
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "pch.h"
+#include <cstdint>
+
+namespace PhysicsCanvas {
+	//Carries the velocities of a run of bodies on by a step and works out how far that moves them, one value (e.g. the x
+	//velocity) at a time for as many bodies at once as the CPU's vector instructions take. Which instructions is worked out
+	//when it's first used. Every kernel does the same float operations in the same order as the scalar one, with no fused
+	//multiply-adds, so they all give exactly the same results and a simulation doesn't depend on the machine it ran on
+	class BatchIntegrator {
+	public:
+		enum Kernel {
+			Scalar,		//a body at a time, on any CPU
+			SSE,		//4 bodies at a time
+			AVX2,		//8
+			AVX512,		//16
+			KERNEL_COUNT
+		};
+
+		static bool Supported(Kernel kernel);
+
+		//the widest kernel this CPU can run
+		static Kernel Best();
+
+		//the kernel Advance() uses, Best() until it's set. Setting one the CPU can't run uses Best() instead
+		static Kernel GetKernel();
+		static void SetKernel(Kernel kernel);
+
+		static const char* Name(Kernel kernel);
+
+		//how many bodies the kernel does with each instruction
+		static int Width(Kernel kernel);
+
+		//For each body from begin to end with any of mask set in its flags: vel = vel + accel * dt, then
+		//out = vel * dt + 1/2 * accel * dt^2. Bodies without it are left as they are.
+		//The arrays must start on a 64 byte boundary, as BodyStore's columns do, so that the bodies are loaded in aligned
+		//blocks; begin and end can be anywhere, the bodies either side of the blocks are done one at a time
+		static void Advance(const float* accel, float* vel, float* out, const uint8_t* flags, uint8_t mask,
+			size_t begin, size_t end, float dt);
+
+		//the same with a particular kernel, which the CPU has to support, for comparing them
+		static void Advance(Kernel kernel, const float* accel, float* vel, float* out, const uint8_t* flags, uint8_t mask,
+			size_t begin, size_t end, float dt);
+	};
+}
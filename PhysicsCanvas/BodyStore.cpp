@@ -0,0 +1,88 @@
+#include "BodyStore.h"
+#include <algorithm>
+
+using namespace PhysicsCanvas;
+
+const std::shared_ptr<BodyStore>& BodyStore::Unplaced() {
+	static std::shared_ptr<BodyStore> store = std::make_shared<BodyStore>();
+	return store;
+}
+
+BodyHandle BodyStore::Add() {
+	std::lock_guard<std::mutex> lock(slotLock);
+	if (!freeSlots.empty()) {
+		BodyHandle handle = freeSlots.back();
+		freeSlots.pop_back();
+		for (int f = 0; f < FIELD_COUNT; f++)
+			columns[f][handle] = 0;
+		flags[handle] = InUse;
+		return handle;
+	}
+	for (int f = 0; f < FIELD_COUNT; f++)
+		columns[f].push_back(0);
+	flags.push_back(InUse);
+	return (BodyHandle)(flags.size() - 1);
+}
+
+void BodyStore::Remove(BodyHandle handle) {
+	std::lock_guard<std::mutex> lock(slotLock);
+	flags[handle] = 0;
+	freeSlots.push_back(handle);
+	if (handle + 1 < flags.size())
+		return;
+	//the store ends at its last slot in use, the free ones after it are dropped rather than kept to be handed out again
+	size_t size = flags.size();
+	while (size > 0 && flags[size - 1] == 0)
+		size--;
+	for (int f = 0; f < FIELD_COUNT; f++)
+		columns[f].resize(size);
+	flags.resize(size);
+	freeSlots.erase(std::remove_if(freeSlots.begin(), freeSlots.end(), [size](BodyHandle h) { return h >= size; }), freeSlots.end());
+}
+
+void BodyStore::Advance(Field accel, Field vel, Field out, size_t begin, size_t end, float dt) {
+	size_t run = begin;
+	while (run < end) {
+		while (run < end && flags[run] == 0)
+			run++;
+		size_t runEnd = run;
+		while (runEnd < end && flags[runEnd] != 0)
+			runEnd++;
+		if (runEnd > run)
+			BatchIntegrator::Advance(Data(accel), Data(vel), Data(out), Flags(), Integrating, run, runEnd, dt);
+		run = runEnd;
+	}
+}
+
+void BodyStore::AdvanceLinear(size_t begin, size_t end, float dt) {
+	for (int axis = 0; axis < 3; axis++)
+		Advance((Field)(AccelerationX + axis), (Field)(VelocityX + axis), (Field)(TranslationX + axis), begin, end, dt);
+}
+
+void BodyStore::AdvanceAngular(size_t begin, size_t end, float dt) {
+	for (int axis = 0; axis < 3; axis++)
+		Advance((Field)(AngAccelerationX + axis), (Field)(AngVelocityX + axis), (Field)(TurnX + axis), begin, end, dt);
+}
+
+BodySlot::BodySlot(const BodySlot& other) : store(other.store), handle(store->Add()) {
+	*this = other;
+}
+
+BodySlot& BodySlot::operator=(const BodySlot& other) {
+	for (int f = 0; f < BodyStore::FIELD_COUNT; f++)
+		store->Set((BodyStore::Field)f, handle, other.store->Get((BodyStore::Field)f, other.handle));
+	store->SetFlag(handle, BodyStore::BoundsStale, other.store->HasFlag(other.handle, BodyStore::BoundsStale));
+	return *this;
+}
+
+void BodySlot::MoveTo(const std::shared_ptr<BodyStore>& to) {
+	if (to == store)
+		return;
+	BodyHandle moved = to->Add();
+	for (int f = 0; f < BodyStore::FIELD_COUNT; f++)
+		to->Set((BodyStore::Field)f, moved, store->Get((BodyStore::Field)f, handle));
+	to->SetFlag(moved, BodyStore::BoundsStale, store->HasFlag(handle, BodyStore::BoundsStale));
+	store->Remove(handle);
+	store = to;
+	handle = moved;
+}
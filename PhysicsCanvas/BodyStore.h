@@ -0,0 +1,126 @@
+#pragma once
+#include "pch.h"
+#include "BatchIntegrator.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+using namespace DirectX;
+
+namespace PhysicsCanvas {
+	//which slot in its store a body's state is in, it stays the same for as long as the body stays in that store
+	typedef uint32_t BodyHandle;
+
+	//hands out memory aligned to Alignment bytes, so a column starts on a cache line and vector loads from it never split one
+	template <typename T, size_t Alignment>
+	struct AlignedAllocator {
+		typedef T value_type;
+		template <typename U> struct rebind { typedef AlignedAllocator<U, Alignment> other; };
+
+		AlignedAllocator() {}
+		template <typename U> AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+		T* allocate(size_t n) { return (T*)::operator new(n * sizeof(T), std::align_val_t(Alignment)); }
+		void deallocate(T* p, size_t) { ::operator delete(p, std::align_val_t(Alignment)); }
+
+		template <typename U> bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+		template <typename U> bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+	};
+
+	//The state of every body that changes as it's simulated, kept as one array per value rather than in each body, so a pass
+	//over all the bodies reads straight through memory instead of jumping from body to body. A body's values are all at its
+	//handle in each array. Slots freed by bodies that have gone are handed out again to new ones, so there can be gaps that
+	//aren't in use, which the passes skip over. Each world has a store of its own, so its steps only go over its own bodies.
+	//Adding a body can move the arrays, so pointers into them only last until then
+	class BodyStore {
+	public:
+		static const size_t ALIGNMENT = 64;
+
+		enum Field {
+			PositionX, PositionY, PositionZ, RotationX, RotationY, RotationZ, VelocityX, VelocityY, VelocityZ,
+			AngVelocityX, AngVelocityY, AngVelocityZ, DimensionX, DimensionY, DimensionZ, Mass,
+			//what an integration step works out part way through, for the passes over every body to pick up
+			AccelerationX, AccelerationY, AccelerationZ, AngAccelerationX, AngAccelerationY, AngAccelerationZ,
+			TranslationX, TranslationY, TranslationZ, TurnX, TurnY, TurnZ,
+			//the world aligned box around the body's bounds, for the broadphase
+			MinX, MinY, MinZ, MaxX, MaxY, MaxZ,
+			FIELD_COUNT
+		};
+
+		enum Flag : uint8_t {
+			InUse = 1,
+			Integrating = 2,	//the body is being simulated this step rather than replayed
+			BoundsStale = 4		//it has moved since its box was last worked out
+		};
+
+		typedef std::vector<float, AlignedAllocator<float, ALIGNMENT>> Column;
+
+		//the store bodies are made in, until a world steps them and moves them into its own
+		static const std::shared_ptr<BodyStore>& Unplaced();
+
+		//a slot with every value 0
+		BodyHandle Add();
+		//frees the slot, and any free ones left at the end of the store, so the passes don't go over them
+		void Remove(BodyHandle handle);
+
+		//the number of slots up to the last one in use, whether or not the ones before it are. Every column is this long
+		size_t Size() { return flags.size(); }
+
+		float* Data(Field field) { return columns[field].data(); }
+		uint8_t* Flags() { return flags.data(); }
+
+		float Get(Field field, BodyHandle handle) { return columns[field][handle]; }
+		void Set(Field field, BodyHandle handle, float value) { columns[field][handle] = value; }
+
+		//the three fields from x, e.g. PositionX for the position
+		XMFLOAT3 Get3(Field x, BodyHandle handle) {
+			return XMFLOAT3(columns[x][handle], columns[x + 1][handle], columns[x + 2][handle]);
+		}
+		void Set3(Field x, BodyHandle handle, const XMFLOAT3& value) {
+			columns[x][handle] = value.x;
+			columns[x + 1][handle] = value.y;
+			columns[x + 2][handle] = value.z;
+		}
+
+		bool HasFlag(BodyHandle handle, Flag flag) { return (flags[handle] & flag) != 0; }
+		void SetFlag(BodyHandle handle, Flag flag, bool on) { flags[handle] = on ? flags[handle] | flag : flags[handle] & ~flag; }
+
+		//for the slots from begin to end that are integrating: carries the velocity on by the acceleration for dt, then works
+		//out how far that moves the body into the translation, the same way as s = ut + 1/2 at^2 with u the new velocity.
+		//Done by the BatchIntegrator for as many slots at once as the CPU can, over each run of slots in use in turn
+		void AdvanceLinear(size_t begin, size_t end, float dt);
+
+		//the same for the angular velocity and acceleration, into the turn
+		void AdvanceAngular(size_t begin, size_t end, float dt);
+	private:
+		//advances the three fields from accel, vel and out for each run of slots in use from begin to end
+		void Advance(Field accel, Field vel, Field out, size_t begin, size_t end, float dt);
+
+		Column columns[FIELD_COUNT];
+		std::vector<uint8_t> flags;
+		std::vector<BodyHandle> freeSlots;
+		std::mutex slotLock;	//bodies are made on the UI thread, but the last reference to one can be dropped on the physics thread
+	};
+
+	//A body's slot in a store. Copying a body gives the copy a slot of its own in the same store with the same values in, so
+	//copies don't share any state, the same as when it was all held in the body. The slot holds on to its store, so a body
+	//can outlive the world it was stepped in
+	class BodySlot {
+	public:
+		BodySlot() : store(BodyStore::Unplaced()), handle(store->Add()) {}
+		BodySlot(const BodySlot& other);
+		BodySlot& operator=(const BodySlot& other);
+		~BodySlot() { store->Remove(handle); }
+
+		BodyStore& Store() const { return *store; }
+		BodyHandle GetHandle() const { return handle; }
+
+		//moves the values into a new slot in to and frees the old one, so the handle changes. Nothing if it's already there
+		void MoveTo(const std::shared_ptr<BodyStore>& to);
+	private:
+		std::shared_ptr<BodyStore> store;
+		BodyHandle handle;
+	};
+}
@@ -1,66 +1,109 @@
 #include "BoundingShape.h"
+#include <cfloat>
 
 using namespace PhysicsCanvas;
 
 XMFLOAT3 BoundingShape::GetMaxPoint() {
-	switch (type) {
-	case Cuboid:
-		XMFLOAT3 maxP = {};
-		for (XMFLOAT3 vert : CuboidVertices()) {
-			if (vert.x >= maxP.x && vert.y >= maxP.y && vert.z >= maxP.z)
-				maxP = vert;
-		}
-		return maxP;
-		break;
-	case Sphere:
-		return PhysMaths::Float3Add(position, PhysMaths::VecTimesByConstant({ 1,1,1 }, dimensions.x));
-		break;
-	}
+	Refresh();
+	return maxPoint;
 }
 
 XMFLOAT3 BoundingShape::GetMinPoint() {
+	Refresh();
+	return minPoint;
+}
+
+void BoundingShape::Refresh() {
+	if (!dirty)
+		return;
+	dirty = false;
+
+	//one quaternion for the whole shape, its rotation matrix rows are the local axes
+	XMFLOAT3X3 rotMat;
+	XMStoreFloat3x3(&rotMat, XMMatrixRotationQuaternion(XMQuaternionRotationRollPitchYaw(rotation.z, rotation.y, rotation.x)));
+	for (int i = 0; i < 3; i++) {
+		axes[i] = XMFLOAT3(rotMat.m[i][0], rotMat.m[i][1], rotMat.m[i][2]);
+	}
+
 	switch (type) {
 	case Cuboid:
-		XMFLOAT3 minP = {};
-		for (XMFLOAT3 vert : CuboidVertices()) {
-			if (vert.x <= minP.x && vert.y <= minP.y && vert.z <= minP.z)
-				minP = vert;
+	{
+		XMFLOAT3 hx = PhysMaths::VecTimesByConstant(axes[0], dimensions.x / 2.0f);
+		XMFLOAT3 hy = PhysMaths::VecTimesByConstant(axes[1], dimensions.y / 2.0f);
+		XMFLOAT3 hz = PhysMaths::VecTimesByConstant(axes[2], dimensions.z / 2.0f);
+		//same vertex order as before: +x half first, then +y before -y, with z alternating
+		float signs[8][3] = {
+			{ 1, 1, 1 }, { 1, 1, -1 }, { 1, -1, -1 }, { 1, -1, 1 },
+			{ -1, 1, 1 }, { -1, 1, -1 }, { -1, -1, -1 }, { -1, -1, 1 }
+		};
+		for (int i = 0; i < 8; i++) {
+			vertices[i] = XMFLOAT3(
+				position.x + signs[i][0] * hx.x + signs[i][1] * hy.x + signs[i][2] * hz.x,
+				position.y + signs[i][0] * hx.y + signs[i][1] * hy.y + signs[i][2] * hz.y,
+				position.z + signs[i][0] * hx.z + signs[i][1] * hy.z + signs[i][2] * hz.z);
+		}
+
+		//take the largest and smallest of each component across all the vertices for the world-aligned box around the cuboid
+		minPoint = maxPoint = vertices[0];
+		for (XMFLOAT3& vert : vertices) {
+			if (vert.x < minPoint.x) minPoint.x = vert.x;
+			if (vert.y < minPoint.y) minPoint.y = vert.y;
+			if (vert.z < minPoint.z) minPoint.z = vert.z;
+			if (vert.x > maxPoint.x) maxPoint.x = vert.x;
+			if (vert.y > maxPoint.y) maxPoint.y = vert.y;
+			if (vert.z > maxPoint.z) maxPoint.z = vert.z;
+		}
+
+		//create edges
+		edges = { {
+			{ vertices[0], vertices[1] }, { vertices[1], vertices[3] }, { vertices[1], vertices[2] }, { vertices[2], vertices[3] },
+			{ vertices[0], vertices[4] }, { vertices[1], vertices[5] }, { vertices[2], vertices[6] }, { vertices[3], vertices[7] },
+			{ vertices[4], vertices[5] }, { vertices[4], vertices[7] }, { vertices[5], vertices[6] }, { vertices[6], vertices[7] }
+		} };
+
+		//create faces
+		faces = { {
+			{ vertices[0], vertices[1], vertices[2], vertices[3] }, //right face
+			{ vertices[0], vertices[1], vertices[5], vertices[4] }, //top face
+			{ vertices[0], vertices[3], vertices[7], vertices[4] }, //front face
+			{ vertices[1], vertices[2], vertices[6], vertices[5] }, //back face
+			{ vertices[4], vertices[5], vertices[6], vertices[7] }, //left face
+			{ vertices[2], vertices[3], vertices[7], vertices[6] }  //bottom face
+		} };
+		for (int i = 0; i < 6; i++) {
+			faceNormals[i] = CuboidFaceNormal(faces[i]);
 		}
-		return minP;
 		break;
+	}
 	case Sphere:
-		return PhysMaths::Float3Add(position, PhysMaths::VecTimesByConstant({ -1,-1,-1 }, dimensions.x));
+		minPoint = PhysMaths::Float3Add(position, PhysMaths::VecTimesByConstant({ -1,-1,-1 }, dimensions.x));
+		maxPoint = PhysMaths::Float3Add(position, PhysMaths::VecTimesByConstant({ 1,1,1 }, dimensions.x));
 		break;
 	}
 }
 
-bool BoundingShape::PointCollidingWithObject(XMFLOAT3 point, std::shared_ptr<BoundingShape> object) {
+bool BoundingShape::PointCollidingWithObject(XMFLOAT3 point, const std::shared_ptr<BoundingShape>& object) {
 	switch (object->type) {
 	case Cuboid:
-		return (point.x >= object->GetMinPoint().x && point.x <= object->GetMaxPoint().x
-			&& point.y >= object->GetMinPoint().y && point.y <= object->GetMaxPoint().y
-			&& point.z >= object->GetMinPoint().z && point.z <= object->GetMaxPoint().z);
-		break;
+	{
+		XMFLOAT3 minP = object->GetMinPoint();
+		XMFLOAT3 maxP = object->GetMaxPoint();
+		return (point.x >= minP.x && point.x <= maxP.x
+			&& point.y >= minP.y && point.y <= maxP.y
+			&& point.z >= minP.z && point.z <= maxP.z);
+	}
 	case Sphere:
 		return PhysMaths::Distance(point, object->position) <= object->dimensions.x;
 		break;
 	}
+	return false;
 }
 
-bool BoundingShape::IsColliding(std::shared_ptr<BoundingShape> first, std::shared_ptr<BoundingShape> other) {
+bool BoundingShape::IsColliding(const std::shared_ptr<BoundingShape>& first, const std::shared_ptr<BoundingShape>& other) {
 	if (first->type == BoundType::Cuboid) {
 		//cube-cube collisions
 		if (other->type == BoundType::Cuboid) {
-			for (XMFLOAT3 v1 : first->CuboidVertices()) {
-				if (PointCollidingWithObject(v1, other))
-					return true;
-			}
-			for (XMFLOAT3 v2 : other->CuboidVertices()) {
-				if (PointCollidingWithObject(v2, first))
-					return true;
-			}
-			//if there is a collision, return true. otherwise, return false
-			return false;
+			return CuboidsColliding(*first, *other, nullptr);
 		}
 		//cube-sphere collisions
 		else {
@@ -93,7 +136,199 @@ bool BoundingShape::IsColliding(std::shared_ptr<BoundingShape> first, std::share
 	}
 }
 
-std::vector<XMFLOAT3> BoundingShape::ResolveCollisions(std::shared_ptr<BoundingShape> first, std::shared_ptr<BoundingShape> other) {
+//keeps the part of the polygon on the inside of the plane dot(planeNormal, p) <= offset, out needs room for count + 1 points
+static int ClipPolygon(const XMFLOAT3* in, int count, XMFLOAT3 planeNormal, float offset, XMFLOAT3* out) {
+	int outCount = 0;
+	for (int i = 0; i < count; i++) {
+		XMFLOAT3 a = in[i];
+		XMFLOAT3 b = in[(i + 1) % count];
+		float da = PhysMaths::Float3Dot(planeNormal, a) - offset;
+		float db = PhysMaths::Float3Dot(planeNormal, b) - offset;
+		if (da <= 0)
+			out[outCount++] = a;
+		//the edge crosses the plane, add the crossing point
+		if ((da < 0 && db > 0) || (da > 0 && db < 0)) {
+			float t = da / (da - db);
+			out[outCount++] = PhysMaths::Float3Add(a, PhysMaths::VecTimesByConstant(PhysMaths::Float3Minus(b, a), t));
+		}
+	}
+	return outCount;
+}
+
+bool BoundingShape::CuboidsColliding(BoundingShape& first, BoundingShape& other, ContactManifold* manifold) {
+	const std::array<XMFLOAT3, 3>& axesA = first.Axes();
+	const std::array<XMFLOAT3, 3>& axesB = other.Axes();
+	float halfA[3] = { first.dimensions.x / 2.0f, first.dimensions.y / 2.0f, first.dimensions.z / 2.0f };
+	float halfB[3] = { other.dimensions.x / 2.0f, other.dimensions.y / 2.0f, other.dimensions.z / 2.0f };
+	XMFLOAT3 centres = PhysMaths::Float3Minus(other.position, first.position);
+
+	//axes 0-2 are first's faces, 3-5 are other's faces and 6-14 are the edge pairs
+	int best = -1;
+	float bestDepth = FLT_MAX;
+	float bestScore = FLT_MAX;
+	XMFLOAT3 bestAxis = {};
+	for (int k = 0; k < 15; k++) {
+		XMFLOAT3 axis;
+		if (k < 3) {
+			axis = axesA[k];
+		}
+		else if (k < 6) {
+			axis = axesB[k - 3];
+		}
+		else {
+			axis = PhysMaths::Float3Cross(axesA[(k - 6) / 3], axesB[(k - 6) % 3]);
+			float length = PhysMaths::Magnitude(axis);
+			//parallel edges, the face axes already cover this direction
+			if (length < 1e-5f)
+				continue;
+			axis = PhysMaths::VecDivByConstant(axis, length);
+		}
+		//half the length of each box's shadow on the axis
+		float rA = 0, rB = 0;
+		for (int i = 0; i < 3; i++) {
+			rA += halfA[i] * fabsf(PhysMaths::Float3Dot(axesA[i], axis));
+			rB += halfB[i] * fabsf(PhysMaths::Float3Dot(axesB[i], axis));
+		}
+		float dist = PhysMaths::Float3Dot(centres, axis);
+		float depth = rA + rB - fabsf(dist);
+		if (depth < 0)
+			return false;
+		//face contacts give steadier manifolds, so an edge axis has to be clearly shallower to be picked
+		float score = k < 6 ? depth : depth * 1.05f + 0.001f;
+		if (score < bestScore) {
+			bestScore = score;
+			bestDepth = depth;
+			best = k;
+			bestAxis = dist < 0 ? PhysMaths::VecTimesByConstant(axis, -1) : axis;
+		}
+	}
+	if (manifold == nullptr)
+		return true;
+
+	manifold->normal = bestAxis;
+	manifold->count = 0;
+	if (best < 6) {
+		//face contact: clip the face of the incident box that faces the reference face against the reference face's sides
+		bool firstIsRef = best < 3;
+		BoundingShape& ref = firstIsRef ? first : other;
+		BoundingShape& inc = firstIsRef ? other : first;
+		const std::array<XMFLOAT3, 3>& refAxes = firstIsRef ? axesA : axesB;
+		const std::array<XMFLOAT3, 3>& incAxes = firstIsRef ? axesB : axesA;
+		const float* refHalf = firstIsRef ? halfA : halfB;
+		const float* incHalf = firstIsRef ? halfB : halfA;
+		int r = best % 3;
+		//reference face normal, pointing at the incident box
+		XMFLOAT3 n = firstIsRef ? bestAxis : PhysMaths::VecTimesByConstant(bestAxis, -1);
+
+		//the incident face is the one whose normal points most against n
+		int j = 0;
+		float jDot = 0;
+		for (int i = 0; i < 3; i++) {
+			float d = PhysMaths::Float3Dot(incAxes[i], n);
+			if (fabsf(d) > fabsf(jDot)) {
+				jDot = d;
+				j = i;
+			}
+		}
+		XMFLOAT3 incCentre = PhysMaths::Float3Add(inc.position, PhysMaths::VecTimesByConstant(incAxes[j], jDot > 0 ? -incHalf[j] : incHalf[j]));
+		XMFLOAT3 u = PhysMaths::VecTimesByConstant(incAxes[(j + 1) % 3], incHalf[(j + 1) % 3]);
+		XMFLOAT3 v = PhysMaths::VecTimesByConstant(incAxes[(j + 2) % 3], incHalf[(j + 2) % 3]);
+
+		//a quad clipped by 4 planes has at most 8 corners
+		XMFLOAT3 poly[8];
+		XMFLOAT3 clipped[8];
+		int count = 4;
+		poly[0] = PhysMaths::Float3Add(incCentre, PhysMaths::Float3Add(u, v));
+		poly[1] = PhysMaths::Float3Add(incCentre, PhysMaths::Float3Minus(u, v));
+		poly[2] = PhysMaths::Float3Minus(incCentre, PhysMaths::Float3Add(u, v));
+		poly[3] = PhysMaths::Float3Minus(incCentre, PhysMaths::Float3Minus(u, v));
+		for (int side = 0; side < 4 && count > 0; side++) {
+			int a = (r + 1 + side / 2) % 3;
+			XMFLOAT3 planeNormal = PhysMaths::VecTimesByConstant(refAxes[a], side % 2 == 0 ? 1.0f : -1.0f);
+			float offset = PhysMaths::Float3Dot(planeNormal, ref.position) + refHalf[a];
+			count = ClipPolygon(poly, count, planeNormal, offset, clipped);
+			for (int i = 0; i < count; i++)
+				poly[i] = clipped[i];
+		}
+
+		//keep the points that have gone through the reference face, moved onto first's surface if first is the reference
+		float refOffset = PhysMaths::Float3Dot(n, ref.position) + refHalf[r];
+		XMFLOAT3 points[8];
+		float depths[8];
+		int found = 0;
+		for (int i = 0; i < count; i++) {
+			float separation = PhysMaths::Float3Dot(n, poly[i]) - refOffset;
+			if (separation <= 0) {
+				points[found] = firstIsRef ? PhysMaths::Float3Minus(poly[i], PhysMaths::VecTimesByConstant(n, separation)) : poly[i];
+				depths[found] = -separation;
+				found++;
+			}
+		}
+
+		if (found <= 4) {
+			for (int i = 0; i < found; i++) {
+				manifold->points[i] = points[i];
+				manifold->depths[i] = depths[i];
+			}
+			manifold->count = found;
+		}
+		else {
+			//keep the furthest points each way along the reference face, which span the contact area
+			int keep[4] = { 0, 0, 0, 0 };
+			XMFLOAT3 t1 = refAxes[(r + 1) % 3];
+			XMFLOAT3 t2 = refAxes[(r + 2) % 3];
+			for (int i = 1; i < found; i++) {
+				if (PhysMaths::Float3Dot(points[i], t1) < PhysMaths::Float3Dot(points[keep[0]], t1)) keep[0] = i;
+				if (PhysMaths::Float3Dot(points[i], t1) > PhysMaths::Float3Dot(points[keep[1]], t1)) keep[1] = i;
+				if (PhysMaths::Float3Dot(points[i], t2) < PhysMaths::Float3Dot(points[keep[2]], t2)) keep[2] = i;
+				if (PhysMaths::Float3Dot(points[i], t2) > PhysMaths::Float3Dot(points[keep[3]], t2)) keep[3] = i;
+			}
+			for (int i = 0; i < 4; i++) {
+				bool duplicate = false;
+				for (int c = 0; c < i; c++) {
+					if (keep[c] == keep[i])
+						duplicate = true;
+				}
+				if (!duplicate) {
+					manifold->points[manifold->count] = points[keep[i]];
+					manifold->depths[manifold->count] = depths[keep[i]];
+					manifold->count++;
+				}
+			}
+		}
+
+		//rounding can clip everything away on a grazing contact, fall back to the middle of the incident face
+		if (manifold->count == 0) {
+			float separation = PhysMaths::Float3Dot(n, incCentre) - refOffset;
+			manifold->points[0] = firstIsRef ? PhysMaths::Float3Minus(incCentre, PhysMaths::VecTimesByConstant(n, separation)) : incCentre;
+			manifold->depths[0] = bestDepth;
+			manifold->count = 1;
+		}
+	}
+	else {
+		//edge contact: find the edge of each box that is furthest along the normal towards the other, then the closest points between them
+		int i = (best - 6) / 3;
+		int j = (best - 6) % 3;
+		XMFLOAT3 pA = first.position;
+		XMFLOAT3 pB = other.position;
+		for (int k = 0; k < 3; k++) {
+			if (k != i)
+				pA = PhysMaths::Float3Add(pA, PhysMaths::VecTimesByConstant(axesA[k], PhysMaths::Float3Dot(axesA[k], bestAxis) > 0 ? halfA[k] : -halfA[k]));
+			if (k != j)
+				pB = PhysMaths::Float3Add(pB, PhysMaths::VecTimesByConstant(axesB[k], PhysMaths::Float3Dot(axesB[k], bestAxis) > 0 ? -halfB[k] : halfB[k]));
+		}
+		XMFLOAT3 between = PhysMaths::Float3Minus(pA, pB);
+		float cosine = PhysMaths::Float3Dot(axesA[i], axesB[j]);
+		float s = (cosine * PhysMaths::Float3Dot(axesB[j], between) - PhysMaths::Float3Dot(axesA[i], between)) / (1.0f - cosine * cosine);
+		s = s < -halfA[i] ? -halfA[i] : (s > halfA[i] ? halfA[i] : s);
+		manifold->points[0] = PhysMaths::Float3Add(pA, PhysMaths::VecTimesByConstant(axesA[i], s));
+		manifold->depths[0] = bestDepth;
+		manifold->count = 1;
+	}
+	return true;
+}
+
+std::array<XMFLOAT3, 2> BoundingShape::ResolveCollisions(const std::shared_ptr<BoundingShape>& first, const std::shared_ptr<BoundingShape>& other) {
 	XMFLOAT3 half(first->dimensions.x / 2.f, first->dimensions.y / 2.f, first->dimensions.z / 2.f);
 	XMFLOAT3 oHalf(other->dimensions.x / 2.f, other->dimensions.y / 2.f, other->dimensions.z / 2.f);
 
@@ -113,9 +348,9 @@ std::vector<XMFLOAT3> BoundingShape::ResolveCollisions(std::shared_ptr<BoundingS
 
 	max2 = PhysMaths::Float3Add(other->position, max2);max2 = PhysMaths::RotateVector(max2, other->rotation);
 
-	float overlapX = min(max1.x, max2.x) - max(min1.x, min2.x);
-	float overlapY = min(max1.y, max2.y) - max(min1.y, min2.y);
-	float overlapZ = min(max1.z, max2.z) - max(min1.z, min2.z);
+	float overlapX = (max1.x < max2.x ? max1.x : max2.x) - (min1.x > min2.x ? min1.x : min2.x);
+	float overlapY = (max1.y < max2.y ? max1.y : max2.y) - (min1.y > min2.y ? min1.y : min2.y);
+	float overlapZ = (max1.z < max2.z ? max1.z : max2.z) - (min1.z > min2.z ? min1.z : min2.z);
 
 	XMFLOAT3 trans1 = XMFLOAT3();
 	XMFLOAT3 trans2 = XMFLOAT3();
@@ -139,79 +374,36 @@ std::vector<XMFLOAT3> BoundingShape::ResolveCollisions(std::shared_ptr<BoundingS
 		trans1.z += moveDistance;
 		trans2.z -= moveDistance;
 	}
-	std::vector<XMFLOAT3> ret;
-	ret.push_back(trans1);
-	ret.push_back(trans2);
-	return ret;
+	return { trans1, trans2 };
 }
 
-std::vector<XMFLOAT3> BoundingShape::CuboidVertices() {
+const std::array<XMFLOAT3, 8>& BoundingShape::CuboidVertices() {
 	assert(type == BoundType::Cuboid && "Not a cuboid!!");
-	XMFLOAT3 halves(dimensions.x / 2.0f, dimensions.y / 2.0f, dimensions.z / 2.0f);
-	//declare positions of vertices
-	XMFLOAT3 v1(halves.x, halves.y, halves.z);
-	v1 = PhysMaths::RotateVector(v1, rotation);
-	v1 = PhysMaths::Float3Add(v1, position);
-	XMFLOAT3 v2(halves.x, halves.y, -halves.z);
-	v2 = PhysMaths::RotateVector(v2, rotation);
-	v2 = PhysMaths::Float3Add(v2, position);
-	XMFLOAT3 v3(halves.x, -halves.y, -halves.z);
-	v3 = PhysMaths::RotateVector(v3, rotation);
-	v3 = PhysMaths::Float3Add(v3, position);
-	XMFLOAT3 v4(halves.x, -halves.y, halves.z);
-	v4 = PhysMaths::RotateVector(v4, rotation);
-	v4 = PhysMaths::Float3Add(v4, position);
-	XMFLOAT3 v5(-halves.x, halves.y, halves.z);
-	v5 = PhysMaths::RotateVector(v5, rotation);
-	v5 = PhysMaths::Float3Add(v5, position);
-	XMFLOAT3 v6(-halves.x, halves.y, -halves.z);
-	v6 = PhysMaths::RotateVector(v6, rotation);
-	v6 = PhysMaths::Float3Add(v6, position);
-	XMFLOAT3 v7(-halves.x, -halves.y, -halves.z);
-	v7 = PhysMaths::RotateVector(v7, rotation);
-	v7 = PhysMaths::Float3Add(v7, position);
-	XMFLOAT3 v8(-halves.x, -halves.y, halves.z);
-	v8 = PhysMaths::RotateVector(v8, rotation);
-	v8 = PhysMaths::Float3Add(v8, position);
-	return { v1, v2, v3, v4, v5, v6, v7, v8 };
+	Refresh();
+	return vertices;
 }
 
-std::vector<Edge> BoundingShape::CuboidEdges() {
+const std::array<Edge, 12>& BoundingShape::CuboidEdges() {
 	assert(type == BoundType::Cuboid && "Not a cuboid!!");
-
-	std::vector<Edge> ret;
-	std::vector<XMFLOAT3> verts = CuboidVertices();
-
-	//create edges
-	ret.push_back({ verts[0], verts[1] });
-	ret.push_back({ verts[1], verts[3] });
-	ret.push_back({ verts[1], verts[2] });
-	ret.push_back({ verts[2], verts[3] });
-	ret.push_back({ verts[0], verts[4] });
-	ret.push_back({ verts[1], verts[5] });
-	ret.push_back({ verts[2], verts[6] });
-	ret.push_back({ verts[3], verts[7] });
-	ret.push_back({ verts[4], verts[5] });
-	ret.push_back({ verts[4], verts[7] });
-	ret.push_back({ verts[5], verts[6] });
-	ret.push_back({ verts[6], verts[7] });
-	return ret;
+	Refresh();
+	return edges;
 }
 
-std::vector<CuboidFace> BoundingShape::CuboidFaces() {
+const std::array<CuboidFace, 6>& BoundingShape::CuboidFaces() {
 	assert(type == BoundType::Cuboid && "Not a cuboid!!");
+	Refresh();
+	return faces;
+}
 
-	std::vector<CuboidFace> ret;
-	std::vector<XMFLOAT3> verts = CuboidVertices();
+const std::array<XMFLOAT3, 6>& BoundingShape::CuboidFaceNormals() {
+	assert(type == BoundType::Cuboid && "Not a cuboid!!");
+	Refresh();
+	return faceNormals;
+}
 
-	//create faces
-	ret.push_back({ verts[0], verts[1], verts[2], verts[3] }); //right face
-	ret.push_back({ verts[0], verts[1], verts[5], verts[4] }); //top face
-	ret.push_back({ verts[0], verts[3], verts[7], verts[4] }); //front face
-	ret.push_back({ verts[1], verts[2], verts[6], verts[5] }); //back face
-	ret.push_back({ verts[4], verts[5], verts[6], verts[7] }); //left face
-	ret.push_back({ verts[2], verts[3], verts[7], verts[6] }); //bottom face
-	return ret;
+const std::array<XMFLOAT3, 3>& BoundingShape::Axes() {
+	Refresh();
+	return axes;
 }
 
 XMFLOAT3 BoundingShape::CuboidFaceCentre(CuboidFace face) {
@@ -234,114 +426,146 @@ XMFLOAT3 BoundingShape::CuboidFaceNormal(CuboidFace face) {
 }
 
 //To find the contact points on object1 with object2, call this method on object1 and pass in object2 as the argument
-std::vector<XMFLOAT3> BoundingShape::ContactPointsTo(std::shared_ptr<BoundingShape> obj2) {
-	std::vector<XMFLOAT3> ret;
-	if (type == BoundType::Cuboid) {
-		std::vector<Edge> edges = CuboidEdges();
-		for (Edge edge : edges) {
-			//If both vertices of the edge are colliding in contact with the object, they are both contact points
-			if (PointCollidingWithObject(edge.vert1, obj2) && PointCollidingWithObject(edge.vert2, obj2)) {
-				//Check that the vertices aren't already in ret to avoid duplicates
-				bool alreadyContained = false;
-				for (XMFLOAT3 vert : ret) {
-					alreadyContained = (edge.vert1.x == vert.x) && (edge.vert1.y == vert.y) && (edge.vert1.z == vert.z);
-					if (alreadyContained)
-						break;
-				}
-				if (!alreadyContained)
-					ret.push_back(edge.vert1);
-				//repeat for the second vertex
-				alreadyContained = false;
-				for (XMFLOAT3 vert : ret) {
-					alreadyContained = (edge.vert2.x == vert.x) && (edge.vert2.y == vert.y) && (edge.vert2.z == vert.z);
-					if (alreadyContained)
-						break;
-				}
-				if (!alreadyContained)
-					ret.push_back(edge.vert2);
-			}
-			//if only the first vertex is in contact with the object
-			else if (PointCollidingWithObject(edge.vert1, obj2)) {
-				bool alreadyContained = false;
-				for (XMFLOAT3 vert : ret) {
-					alreadyContained = (edge.vert1.x == vert.x) && (edge.vert1.y == vert.y) && (edge.vert1.z == vert.z);
-					if (alreadyContained)
-						break;
-				}
-				if (!alreadyContained)
-					ret.push_back(edge.vert1);
-				//Traverse along this edge to see where it stops being in contact, registering that point as a contact point
-				XMFLOAT3 dir(edge.vert2.x - edge.vert1.x, edge.vert2.y - edge.vert1.y, edge.vert2.z - edge.vert1.z);
-				XMFLOAT3 point = edge.vert1;
-				XMFLOAT3 point2;
-				for (float p = 0.01f; p < 1.0f; p += 1.0f) {
-					point2 = { edge.vert1.x + (dir.x * p), edge.vert1.y + (dir.y * p), edge.vert1.z + (dir.z * p) };
-					if (!PointCollidingWithObject(point2, obj2)) {
-						break; //The cut-off point has been found and the previous point is saved to "point" so now we can append it
-					}
-					else {
-						point = point2;
-					}
-				}
-				alreadyContained = false;
-				for (XMFLOAT3 vert : ret) {
-					alreadyContained = (point.x == vert.x) && (point.y == vert.y) && (point.z == vert.z);
-					if (alreadyContained)
-						break;
-				}
-				if (!alreadyContained)
-					ret.push_back(point);
-			}
-			//if only the second vertex is in contact
-			else if (PointCollidingWithObject(edge.vert2, obj2)) {
-				bool alreadyContained = false;
-				for (XMFLOAT3 vert : ret) {
-					alreadyContained = (edge.vert2.x == vert.x) && (edge.vert2.y == vert.y) && (edge.vert2.z == vert.z);
-					if (alreadyContained)
-						break;
-				}
-				if (!alreadyContained)
-					ret.push_back(edge.vert2);
-				//Traverse along this edge to see where it stops being in contact, registering that point as a contact point
-				XMFLOAT3 dir(edge.vert1.x - edge.vert2.x, edge.vert1.y - edge.vert2.y, edge.vert1.z - edge.vert2.z);
-				XMFLOAT3 point = edge.vert2;
-				XMFLOAT3 point2;
-				for (float p = 0.01f; p < 1.0f; p += 0.01f) {
-					point2 = { edge.vert2.x + (dir.x * p), edge.vert2.y + (dir.y * p), edge.vert2.z + (dir.z * p) };
-					if (!PointCollidingWithObject(point2, obj2)) {
-						break; //The cut-off point has been found and the previous point is saved to "point" so now we can append it
-					}
-					else {
-						point = point2;
-					}
-				}
-				alreadyContained = false;
-				for (XMFLOAT3 vert : ret) {
-					alreadyContained = (point.x == vert.x) && (point.y == vert.y) && (point.z == vert.z);
-					if (alreadyContained)
-						break;
-				}
-				if (!alreadyContained)
-					ret.push_back(point);
-			}
-		}
+ContactManifold BoundingShape::ContactPointsTo(const std::shared_ptr<BoundingShape>& obj2) {
+	ContactManifold ret = {};
+	if (type == BoundType::Cuboid && obj2->type == BoundType::Cuboid) {
+		CuboidsColliding(*this, *obj2, &ret);
 		return ret;
 	}
-	else {
 
+	//anything involving a sphere touches at a single point
+	XMFLOAT3 centreToCentre = PhysMaths::Float3Minus(obj2->position, position);
+	float centreDist = PhysMaths::Magnitude(centreToCentre);
+	XMFLOAT3 fallbackNormal = centreDist > 0 ? PhysMaths::VecDivByConstant(centreToCentre, centreDist) : XMFLOAT3(0, 1, 0);
+	if (type == BoundType::Cuboid) {
+		//cube-sphere: the point on the cube closest to the sphere's centre
+		XMFLOAT3 closest = ClosestPointOnCuboid(obj2->position);
+		XMFLOAT3 toCentre = PhysMaths::Float3Minus(obj2->position, closest);
+		float dist = PhysMaths::Magnitude(toCentre);
+		if (dist > obj2->dimensions.x)
+			return ret;
+		ret.normal = dist > 0 ? PhysMaths::VecDivByConstant(toCentre, dist) : fallbackNormal;
+		ret.points[0] = closest;
+		ret.depths[0] = obj2->dimensions.x - dist;
+	}
+	else {
+		//sphere-cube and sphere-sphere: the point on this sphere facing the closest point of the other shape
+		XMFLOAT3 closest = obj2->type == BoundType::Cuboid ? obj2->ClosestPointOnCuboid(position) : obj2->position;
+		XMFLOAT3 toClosest = PhysMaths::Float3Minus(closest, position);
+		float dist = PhysMaths::Magnitude(toClosest);
+		float reach = obj2->type == BoundType::Cuboid ? dimensions.x : dimensions.x + obj2->dimensions.x;
+		if (dist > reach)
+			return ret;
+		ret.normal = dist > 0 ? PhysMaths::VecDivByConstant(toClosest, dist) : fallbackNormal;
+		ret.points[0] = PhysMaths::Float3Add(position, PhysMaths::VecTimesByConstant(ret.normal, dimensions.x));
+		ret.depths[0] = reach - dist;
 	}
+	ret.count = 1;
+	return ret;
 }
 
 //Find closest point on obj2 from obj1 (caller of the method)
-XMFLOAT3 BoundingShape::ClosestPointOn(std::shared_ptr<BoundingShape> obj2) {
+XMFLOAT3 BoundingShape::ClosestPointOn(const std::shared_ptr<BoundingShape>& obj2) {
 	switch (obj2->GetType()) {
 	case BoundType::Cuboid:
-
-		break;
+		return obj2->ClosestPointOnCuboid(position);
 	case BoundType::Sphere:
+	default:
 		XMFLOAT3 dir(obj2->position.x - position.x, obj2->position.y - position.y, obj2->position.z - position.z);
 		dir = PhysMaths::VecTimesByConstant(dir, obj2->dimensions.x / PhysMaths::Magnitude(dir));
 		return XMFLOAT3(obj2->position.x + dir.x, obj2->position.y + dir.y, obj2->position.z + dir.z);
-		break;
 	}
 }
+
+XMFLOAT3 BoundingShape::ClosestPointOnCuboid(XMFLOAT3 point) {
+	assert(type == BoundType::Cuboid && "Not a cuboid!!");
+	Refresh();
+	//clamp the point to the box along each of its local axes
+	float halves[3] = { dimensions.x / 2.0f, dimensions.y / 2.0f, dimensions.z / 2.0f };
+	XMFLOAT3 offset = PhysMaths::Float3Minus(point, position);
+	XMFLOAT3 ret = position;
+	for (int i = 0; i < 3; i++) {
+		float d = PhysMaths::Float3Dot(offset, axes[i]);
+		d = d < -halves[i] ? -halves[i] : (d > halves[i] ? halves[i] : d);
+		ret = PhysMaths::Float3Add(ret, PhysMaths::VecTimesByConstant(axes[i], d));
+	}
+	return ret;
+}
+
+bool BoundingShape::RayIntersect(XMFLOAT3 origin, XMFLOAT3 dir, float maxDist, float& distance, XMFLOAT3& normal) {
+	XMFLOAT3 toCentre = PhysMaths::Float3Minus(position, origin);
+	switch (type) {
+	case Cuboid:
+	{
+		//slab test in the box's own frame, one pair of faces per local axis
+		Refresh();
+		float halves[3] = { dimensions.x / 2.0f, dimensions.y / 2.0f, dimensions.z / 2.0f };
+		float tMin = -FLT_MAX;
+		float tMax = FLT_MAX;
+		XMFLOAT3 enterNormal = {};
+		for (int i = 0; i < 3; i++) {
+			float e = PhysMaths::Float3Dot(axes[i], toCentre);
+			float f = PhysMaths::Float3Dot(axes[i], dir);
+			if (fabsf(f) > 1e-8f) {
+				float t1 = (e + halves[i]) / f;
+				float t2 = (e - halves[i]) / f;
+				//t1 is where the ray crosses the face on the +axis side, so if it is the later crossing the ray enters through the -axis face
+				float sign = 1.0f;
+				if (t1 > t2) {
+					float temp = t1;
+					t1 = t2;
+					t2 = temp;
+					sign = -1.0f;
+				}
+				if (t1 > tMin) {
+					tMin = t1;
+					enterNormal = PhysMaths::VecTimesByConstant(axes[i], sign);
+				}
+				if (t2 < tMax) tMax = t2;
+				if (tMin > tMax || tMax < 0)
+					return false;
+			}
+			//ray runs parallel to these faces, so it misses unless it's already between them
+			else if (-e - halves[i] > 0 || -e + halves[i] < 0) {
+				return false;
+			}
+		}
+		if (tMin > maxDist)
+			return false;
+		if (tMin < 0) {
+			distance = 0;
+			normal = PhysMaths::VecTimesByConstant(dir, -1);
+		}
+		else {
+			distance = tMin;
+			normal = enterNormal;
+		}
+		return true;
+	}
+	case Sphere:
+	{
+		//solve |origin + t*dir - centre| = r for t
+		float radius = dimensions.x;
+		float b = PhysMaths::Float3Dot(toCentre, dir);
+		float c = PhysMaths::Float3Dot(toCentre, toCentre) - radius * radius;
+		if (c > 0 && b < 0)
+			return false;	//starts outside and points away
+		float discriminant = b * b - c;
+		if (discriminant < 0)
+			return false;
+		float t = b - sqrtf(discriminant);
+		if (t > maxDist)
+			return false;
+		if (t < 0) {
+			distance = 0;
+			normal = PhysMaths::VecTimesByConstant(dir, -1);
+		}
+		else {
+			distance = t;
+			normal = PhysMaths::VecDivByConstant(PhysMaths::Float3Minus(PhysMaths::Float3Add(origin, PhysMaths::VecTimesByConstant(dir, t)), position), radius);
+		}
+		return true;
+	}
+	}
+	return false;
+}
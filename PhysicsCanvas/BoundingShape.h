@@ -1,7 +1,7 @@
 #pragma once
 #include "pch.h"
-#include "..\Common\DirectXHelper.h"
 #include "PhysMaths.h"
+#include <array>
 
 using namespace DirectX;
 
@@ -16,54 +16,92 @@ namespace PhysicsCanvas {
 		XMFLOAT3 vert3;
 		XMFLOAT3 vert4;
 	};
+	//Where two shapes touch. Fixed size so that building one never allocates.
+	//The points lie on the surface of the first shape and normal points from the first shape towards the second.
+	struct ContactManifold {
+		XMFLOAT3 normal;
+		int count;
+		XMFLOAT3 points[4];
+		float depths[4];	//penetration depth at each point
+	};
 
 	class BoundingShape {
 	public:
-		static enum BoundType {
+		enum BoundType {
 			Cuboid, Sphere
 		};
 
 		BoundingShape(BoundType type_, XMFLOAT3 pos, XMFLOAT3 rot, XMFLOAT3 dims)
-			: type(type_), position(pos), rotation(rot), dimensions(dims) {}
+			: type(type_), position(pos), rotation(rot), dimensions(dims), dirty(true) {}
 
-		void SetPosition(XMFLOAT3 pos) { position = pos; }
+		//changing the transform marks the cached world-space geometry as out of date, it gets rebuilt the next time it's asked for
+		void SetPosition(XMFLOAT3 pos) { position = pos; dirty = true; }
 
-		void SetRotation(XMFLOAT3 rot) { rotation = rot; }
+		void SetRotation(XMFLOAT3 rot) { rotation = rot; dirty = true; }
 		
-		void SetDimensions(XMFLOAT3 dims) { dimensions = dims; }
+		void SetDimensions(XMFLOAT3 dims) { dimensions = dims; dirty = true; }
 
 		XMFLOAT3 GetMaxPoint();
 
 		XMFLOAT3 GetMinPoint();
 
-		static bool PointCollidingWithObject(XMFLOAT3 point, std::shared_ptr<BoundingShape> object);
+		static bool PointCollidingWithObject(XMFLOAT3 point, const std::shared_ptr<BoundingShape>& object);
+
+		static bool IsColliding(const std::shared_ptr<BoundingShape>& first, const std::shared_ptr<BoundingShape>& other);
+
+		//Separating axis test between two oriented boxes: the 3 face axes of each box and the 9 edge-edge cross products.
+		//Stops at the first axis that separates them. If manifold isn't null it is filled with the contacts on first.
+		static bool CuboidsColliding(BoundingShape& first, BoundingShape& other, ContactManifold* manifold);
+
+		static std::array<XMFLOAT3, 2> ResolveCollisions(const std::shared_ptr<BoundingShape>& first, const std::shared_ptr<BoundingShape>& other);
 
-		static bool IsColliding(std::shared_ptr<BoundingShape> first, std::shared_ptr<BoundingShape> other);
+		const std::array<XMFLOAT3, 8>& CuboidVertices();
 
-		static std::vector<XMFLOAT3> ResolveCollisions(std::shared_ptr<BoundingShape> first, std::shared_ptr<BoundingShape> other);
+		const std::array<Edge, 12>& CuboidEdges();
 
-		std::vector<XMFLOAT3> CuboidVertices();
+		const std::array<CuboidFace, 6>& CuboidFaces();
 
-		std::vector<Edge> CuboidEdges();
+		//same order as CuboidFaces()
+		const std::array<XMFLOAT3, 6>& CuboidFaceNormals();
 
-		std::vector<CuboidFace> CuboidFaces();
+		//the shape's local x, y and z axes in world space (the rows of its rotation matrix)
+		const std::array<XMFLOAT3, 3>& Axes();
 
 		static XMFLOAT3 CuboidFaceCentre(CuboidFace face);
 
 		XMFLOAT3 CuboidFaceNormal(CuboidFace face);
 
 		//To find the contact points on object1 with object2, call this method on object1 and pass in object2 as the argument
-		std::vector<XMFLOAT3> ContactPointsTo(std::shared_ptr<BoundingShape> obj2);
+		ContactManifold ContactPointsTo(const std::shared_ptr<BoundingShape>& obj2);
 
 		//Find closest point on obj2 from obj1 (caller of the method)
-		XMFLOAT3 ClosestPointOn(std::shared_ptr<BoundingShape> obj2);
+		XMFLOAT3 ClosestPointOn(const std::shared_ptr<BoundingShape>& obj2);
+
+		//closest point in or on this cuboid to the given point
+		XMFLOAT3 ClosestPointOnCuboid(XMFLOAT3 point);
+
+		//Casts a ray against the exact shape (dir should be normalised). On a hit, distance is how far along the ray it is
+		//and normal is the outward surface normal there. A ray starting inside the shape hits at distance 0.
+		bool RayIntersect(XMFLOAT3 origin, XMFLOAT3 dir, float maxDist, float& distance, XMFLOAT3& normal);
 
 		BoundType GetType() { return type; }
 	private:
+		//rebuilds the cached geometry below if the transform has changed since it was last built
+		void Refresh();
+
 		BoundType type;
 		XMFLOAT3 position;
 		XMFLOAT3 rotation;
 		XMFLOAT3 dimensions;
 
+		bool dirty;
+		std::array<XMFLOAT3, 3> axes;
+		std::array<XMFLOAT3, 8> vertices;
+		std::array<Edge, 12> edges;
+		std::array<CuboidFace, 6> faces;
+		std::array<XMFLOAT3, 6> faceNormals;
+		XMFLOAT3 minPoint;
+		XMFLOAT3 maxPoint;
+
 	};
 }
\ No newline at end of file
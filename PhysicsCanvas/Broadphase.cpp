@@ -0,0 +1,74 @@
+#include "Broadphase.h"
+#include "SweepAndPrune.h"
+#include "SpatialHashBroadphase.h"
+#include "AABBTreeBroadphase.h"
+
+using namespace PhysicsCanvas;
+
+std::unique_ptr<Broadphase> Broadphase::Create(Type type) {
+	switch (type) {
+	case SpatialHash:
+		return std::unique_ptr<Broadphase>(new SpatialHashBroadphase());
+	case DynamicTree:
+		return std::unique_ptr<Broadphase>(new AABBTreeBroadphase());
+	case SweepPrune:
+	default:
+		return std::unique_ptr<Broadphase>(new SweepAndPrune());
+	}
+}
+
+bool Broadphase::SyncProxies(std::list<std::shared_ptr<PhysicsBody>>& bodies) {
+	if (bodies.size() == proxies.size()) {
+		bool unchanged = true;
+		int i = 0;
+		for (std::shared_ptr<PhysicsBody>& body : bodies) {
+			//a body moved into a world's store has a new handle, so it's started again for that as well
+			if (proxies[i].body != body || proxies[i].handle != body->GetHandle()) {
+				unchanged = false;
+				break;
+			}
+			i++;
+		}
+		if (unchanged)
+			return true;
+	}
+	//a body has been added or removed, so start again from scratch
+	proxies.clear();
+	for (std::shared_ptr<PhysicsBody>& body : bodies) {
+		proxies.push_back({ body, body->GetHandle(), XMFLOAT3(), XMFLOAT3() });
+	}
+	return false;
+}
+
+void Broadphase::RefreshBounds() {
+	for (Proxy& p : proxies) {
+		BodyStore& store = p.body->GetStore();
+		//the step works the boxes out as it moves the bodies, so this is only for ones moved since, e.g. in the editor
+		if (store.HasFlag(p.handle, BodyStore::BoundsStale))
+			p.body->RefreshBounds();
+		p.minP = store.Get3(BodyStore::MinX, p.handle);
+		p.maxP = store.Get3(BodyStore::MaxX, p.handle);
+	}
+}
+
+void Broadphase::RayQuery(XMFLOAT3 origin, XMFLOAT3 dir, float maxDist, std::vector<int>& hits) {
+	hits.clear();
+	float tEnter;
+	for (int i = 0; i < (int)proxies.size(); i++) {
+		if (PhysMaths::RayHitsAABB(origin, dir, proxies[i].minP, proxies[i].maxP, maxDist, tEnter))
+			hits.push_back(i);
+	}
+}
+
+void Broadphase::PointQuery(XMFLOAT3 point, std::vector<int>& hits) {
+	BoxQuery(point, point, hits);
+}
+
+void Broadphase::BoxQuery(XMFLOAT3 minP, XMFLOAT3 maxP, std::vector<int>& hits) {
+	hits.clear();
+	Proxy box = { nullptr, 0, minP, maxP };
+	for (int i = 0; i < (int)proxies.size(); i++) {
+		if (Overlaps(proxies[i], box))
+			hits.push_back(i);
+	}
+}
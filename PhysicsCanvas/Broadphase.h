@@ -0,0 +1,69 @@
+#pragma once
+#include "pch.h"
+#include "PhysicsBody.h"
+#include <list>
+#include <vector>
+
+using namespace DirectX;
+
+namespace PhysicsCanvas {
+	//a pair of indices into the broadphase's body list, the first index is always the smaller one
+	typedef std::pair<int, int> BodyPair;
+
+	//Culls the bodies in the scene down to the pairs whose bounds could be touching, so that the narrowphase
+	//(BoundingShape::IsColliding) only has to be run on those
+	class Broadphase {
+	public:
+		enum Type {
+			SweepPrune, SpatialHash, DynamicTree
+		};
+
+		static std::unique_ptr<Broadphase> Create(Type type);
+
+		virtual ~Broadphase() {}
+
+		virtual Type GetType() = 0;
+
+		//call once per step before CandidatePairs(), bodies that were added or removed since the last call are picked up here
+		virtual void Update(std::list<std::shared_ptr<PhysicsBody>>& bodies) = 0;
+
+		//every overlapping pair appears exactly once
+		const std::vector<BodyPair>& CandidatePairs() { return pairs; }
+
+		std::shared_ptr<PhysicsBody>& GetBody(int index) { return proxies[index].body; }
+
+		//The queries below work on the bounds from the last Update() and fill hits with body indices in list order.
+		//These versions just check every body, broadphases with a spatial structure override them.
+
+		//bodies whose AABB the ray enters within maxDist, dir should be normalised
+		virtual void RayQuery(XMFLOAT3 origin, XMFLOAT3 dir, float maxDist, std::vector<int>& hits);
+
+		//bodies whose AABB contains the point
+		virtual void PointQuery(XMFLOAT3 point, std::vector<int>& hits);
+
+		//bodies whose AABB overlaps the box
+		virtual void BoxQuery(XMFLOAT3 minP, XMFLOAT3 maxP, std::vector<int>& hits);
+	protected:
+		struct Proxy {
+			std::shared_ptr<PhysicsBody> body;
+			BodyHandle handle;	//where the body's box is in the store
+			XMFLOAT3 minP;
+			XMFLOAT3 maxP;
+		};
+
+		//returns true if the list of bodies is the same as last step, otherwise rebuilds the proxies
+		bool SyncProxies(std::list<std::shared_ptr<PhysicsBody>>& bodies);
+
+		//refreshes the AABB of every proxy from the store, working out any that are out of date from the body's bounds first
+		void RefreshBounds();
+
+		static bool Overlaps(const Proxy& a, const Proxy& b) {
+			return a.minP.x <= b.maxP.x && a.maxP.x >= b.minP.x
+				&& a.minP.y <= b.maxP.y && a.maxP.y >= b.minP.y
+				&& a.minP.z <= b.maxP.z && a.maxP.z >= b.minP.z;
+		}
+
+		std::vector<Proxy> proxies;
+		std::vector<BodyPair> pairs;
+	};
+}
@@ -3,6 +3,7 @@
 
 #include "..\Common\DirectXHelper.h"
 #include <DirectXMath.h>
+#include <limits>
 #include <sstream>
 #include "../ArrowMesh.h"
 #include "../im-neo-sequencer-main/imgui_neo_sequencer.h"
@@ -21,6 +22,10 @@ Sample3DSceneRenderer::Sample3DSceneRenderer(const std::shared_ptr<DX::DeviceRes
 	is_graphing(false), data_obtained(false)
 {
 	library = std::unique_ptr<ProjectLib>(new ProjectLib(m_deviceResources));
+	physics = std::unique_ptr<PhysicsThread>(new PhysicsThread(
+		[this] { Step(); },
+		[this](WorldSnapshot& snapshot) { TakeSnapshot(snapshot); }
+	));
 	CreateDeviceDependentResources();
 	CreateWindowSizeDependentResources();
 }
@@ -68,17 +73,11 @@ void Sample3DSceneRenderer::SaveToFile() {
 		return;
 	is_filing = true;
 
+	std::lock_guard<std::recursive_mutex> lock(physics->WorldLock());
 	float current_time = u_Time;
 	TimeJump(0);
 
-	std::stringstream data;
-	int i = 0;
-	for (std::shared_ptr<PhysicsBody> body : pBodies) {
-		if (i > 0)
-			data << body->BodyData() << "\n";
-		i++;
-	}
-	std::string d = data.str();
+	std::string d = SimFile::Serialize(pBodies);
 	if (currentFile == "NONE") {
 		concurrency::create_task(library->getLocalFolder()->CreateFileAsync("Unnamed simulation.psim", Windows::Storage::CreationCollisionOption::GenerateUniqueName))
 		.then([this, d](Windows::Storage::StorageFile^ newFile) {
@@ -122,127 +121,13 @@ void Sample3DSceneRenderer::SaveToFile() {
 }
 
 void Sample3DSceneRenderer::LoadFromFile(std::string d) { //d represents data input
+	std::lock_guard<std::recursive_mutex> lock(physics->WorldLock());
 	pBodies.clear();
 	CreateDeviceDependentResources();
-	std::istringstream dss(d);
-	//read file contents into a variable
-	std::vector<std::string> data;
-	while (dss) {
-		std::string line;
-		std::getline(dss, line);
-		data.push_back(line);
-	}
-	//process contents to load simulation
-	std::vector<PhysicsBody> bodies;
-	PhysicsBody b;
-	std::vector<std::shared_ptr<PEvent>> events;
-	std::shared_ptr<PEvent> e;
-	DirectX::XMFLOAT3 float3Buffer;
-	Force* eForce = dynamic_cast<Force*>(e.get());
-	for (std::string l : data) {
-		//split the string into a list
-		std::istringstream d(l);
-		std::vector<std::string> words;
-		std::string word;
-		while (std::getline(d, word, ' ')) {
-			words.push_back(word);
-		}
-		if (words.size() > 0) {
-			//to process the line, go through its words one by one
-			if (words[0] == "OBJECT") {
-				if (words[1] == "KINEMATIC") {/*No need to make changes if this is a kinematic body since its the default*/ }
-			}
-			else if (words[0] == "NAME") {
-				std::string name = "";
-				for (int i = 1; i < words.size(); i++) {
-					name += words[i] + " ";
-				}
-				name = name.substr(0, name.size() - 1); //get rid of extra space
-				b.GiveName(name);
-			}
-			else if (words[0] == "COL") {
-				float3Buffer = { std::stof(words[1].c_str()), std::stof(words[2].c_str()), std::stof(words[3].c_str()) };
-			}
-			else if (words[0] == "SHAPE") {
-				b.Create(words[1] == "Cuboid" ? CUBE : SPHERE, m_deviceResources);
-			}
-			else if (words[0] == "DIMS") {
-				switch (b.GetBounds()->GetType()) {
-				case BoundingShape::Cuboid:
-					b.ApplyScale(XMFLOAT3(std::stof(words[1].c_str()), std::stof(words[2].c_str()), std::stof(words[3].c_str())));
-					break;
-				case BoundingShape::Sphere:
-					b.ApplyScale(XMFLOAT3(std::stof(words[1].c_str()), std::stof(words[1].c_str()), std::stof(words[1].c_str())));
-					break;
-				}
-			}
-			else if (words[0] == "POS") {
-				b.ApplyTranslation(XMFLOAT3(std::stof(words[1].c_str()), std::stof(words[2].c_str()), std::stof(words[3].c_str())));
-			}
-			else if (words[0] == "ROT") {
-				b.ApplyRotation(XMFLOAT3(std::stof(words[1].c_str()), std::stof(words[2].c_str()), std::stof(words[3].c_str())));
-			}
-			else if (words[0] == "VEL") {
-				b.SetVelocity(XMFLOAT3(std::stof(words[1].c_str()), std::stof(words[2].c_str()), std::stof(words[3].c_str())));
-			}
-			else if (words[0] == "AVEL") {
-				b.SetAngVelocity(XMFLOAT3(std::stof(words[1].c_str()), std::stof(words[2].c_str()), std::stof(words[3].c_str())));
-			}
-			else if (words[0] == "MASS") {
-				b.SetMass(std::stof(words[1].c_str()));
-			}
-			//handle adding events from the file data
-			else if (words[0] == "EVENT") {
-				if (words[1] == "FORCE") {
-					e = std::make_shared<Force>(Force::Constant, XMFLOAT3());
-					eForce = dynamic_cast<Force*>(e.get());
-				}
-			}
-			else if (words[0] == "ID") {
-				std::string id = "";
-				for (int i = 1; i < words.size(); i++) {
-					id += words[i] + " ";
-				}
-				id = id.substr(0, id.size() - 1); //get rid of extra space
-				e->SetId(id);
-			}
-			else if (words[0] == "START") {
-				e->SetStart(std::stof(words[1].c_str()));
-			}
-			else if (words[0] == "FTYPE") {
-				if (eForce) {
-					if (words[1] == "Constant")
-						eForce->SetForceType(Force::Constant);
-					else if (words[1] == "Impulse")
-						eForce->SetForceType(Force::Impulse);
-				}
-			}
-			else if (words[0] == "END") {
-				e->SetEnd(std::stof(words[1].c_str()));
-			}
-			else if (words[0] == "DIR") {
-				if (eForce)
-					eForce->SetDirection(XMFLOAT3(std::stof(words[1].c_str()), std::stof(words[2].c_str()), std::stof(words[3].c_str())));
-			}
-			else if (words[0] == "FROM") {
-				if (eForce)
-					eForce->SetFrom(XMFLOAT3(std::stof(words[1].c_str()), std::stof(words[2].c_str()), std::stof(words[3].c_str())));
-			}
-			else if (words[0] == "ENDEVENT") {
-				events.push_back(e);
-				e = std::make_shared<PEvent>();
-			}
-			else if (words[0] == "ENDOBJECT") {
-				for (std::shared_ptr<PEvent> ev : events)
-					b.AddEvent(ev);
-				bodies.push_back(b);
-				b = PhysicsBody();
-			}
-		}
-	}
-	for (PhysicsBody bo : bodies) {
-		pBodies.push_back(std::make_shared<PhysicsBody>(bo));
-	}
+	for (std::shared_ptr<PhysicsBody>& body : SimFile::Parse(d, m_deviceResources))
+		pBodies.push_back(body);
+	TimeWipe();
+	physics->Refresh();
 }
 
 // Called once per frame
@@ -255,9 +140,8 @@ void Sample3DSceneRenderer::Update(DX::StepTimer const& timer) {
 
 	controller->Update(wnd);	//updates position and rotation of camera based on input
 
-	if (controller->GetClick().x != -2) {
+	if (controller->GetClick().x != -2)
 		RaycastFromClick(controller->GetClick().x, controller->GetClick().y);
-	}
 	//ensure camera controller can't go beneath the floor
 	if (controller->get_Position().y <= 0.1f) {
 		controller->SetPosition(
@@ -265,9 +149,107 @@ void Sample3DSceneRenderer::Update(DX::StepTimer const& timer) {
 		);
 	}
 
-	if (is_stepping) {
-		Step();
+	//the physics thread does the stepping, this just keeps it in line with the time manager's settings
+	physics->SetSpeed(real_time ? sim_speed : 0, max_substeps);
+	physics->SetRunning(is_stepping);
+}
+
+//what the object manager shows of an event, or of a force acting that isn't one of the body's events if event is null
+static EventView ViewOf(PEvent& e, const std::shared_ptr<PEvent>& event) {
+	EventView view;
+	view.event = event;
+	view.number = e.GetNumber();
+	view.id = e.GetId();
+	view.start = e.GetStart();
+	view.end = e.GetEnd();
+	view.toggle = e.GetToggle();
+	view.type = e.GetEventType();
+	Force* force = view.type == PEvent::eventType::Force ? dynamic_cast<Force*>(&e) : nullptr;
+	view.forceType = force ? force->GetForceType() : Force::Constant;
+	view.direction = force ? force->GetDirection() : XMFLOAT3();
+	view.from = force ? force->GetFrom() : XMFLOAT3();
+	view.colour = force ? force->GetColour() : XMFLOAT3();
+	view.magnitude = force ? force->Magnitude() : 0.0f;
+	return view;
+}
+
+void Sample3DSceneRenderer::TakeSnapshot(WorldSnapshot& snapshot) {
+	snapshot.time = u_Time;
+	snapshot.latestTime = latest_Time;
+	//the events' starts come already sorted from the index, which is only rebuilt when an event changes
+	const EventIndex& events = world.Events(pBodies);
+	snapshot.bodies.resize(pBodies.size());
+	snapshot.timeline.resize(pBodies.size());
+	int i = 0;
+	for (std::shared_ptr<PhysicsBody>& body : pBodies) {
+		snapshot.bodies[i] = { body, body->GetPosition(), body->GetRotation(), body->GetDimensions() };
+		TimelineRow& row = snapshot.timeline[i];
+		row.name = body->GetName();
+		row.keyframes.clear();
+		//the floor doesn't get a row
+		if (i > 0) {
+			for (float start : events.StartsOf(i))
+				row.keyframes.push_back(start * 1000);
+			for (const std::tuple<float, std::string>& stamp : body->GetTimestamps())
+				row.keyframes.push_back(std::get<0>(stamp) * 1000);
+		}
+		i++;
 	}
+
+	//what's acting now and what the last jump in time went past the start or end of, by body and event
+	events.ActiveAt(u_Time, actingEvents);
+	const std::vector<EventIndex::Entry>* lists[] = { &actingEvents, &passedEvents };
+	std::vector<EventSpan>* spans[] = { &snapshot.acting, &snapshot.passed };
+	for (int l = 0; l < 2; l++) {
+		spans[l]->clear();
+		for (const EventIndex::Entry& entry : *lists[l]) {
+			if (entry.body >= (int)snapshot.bodies.size())
+				continue;
+			PhysicsBody& body = *snapshot.bodies[entry.body].body;
+			if (entry.event >= (int)body.GetForceEvents().size())
+				continue;
+			spans[l]->push_back({ body.GetName(), body.GetForceEvents()[entry.event]->GetId(), entry.start, entry.end });
+		}
+	}
+
+	snapshot.hasSelected = selectedBody != nullptr;
+	if (selectedBody != nullptr) {
+		BodyView& view = snapshot.selected;
+		view.body = selectedBody;
+		view.name = selectedBody->GetName();
+		view.position = selectedBody->GetPosition();
+		view.rotation = selectedBody->GetRotation();
+		view.velocity = selectedBody->GetVelocity();
+		view.angVelocity = selectedBody->GetAngularVelocity();
+		view.dimensions = selectedBody->GetDimensions();
+		view.mass = selectedBody->GetMass();
+		view.bounds = std::make_shared<BoundingShape>(*selectedBody->GetBounds());
+		view.events.clear();
+		for (const std::shared_ptr<PEvent>& e : selectedBody->GetEvents())
+			view.events.push_back(ViewOf(*e, e));
+		//the list of forces acting is reused by Torque(), so they're copied out first
+		const std::vector<Force*>& acting = selectedBody->ActiveForces(u_Time);
+		view.resultant = Force::ResultantF(acting).GetDirection();
+		view.acting.clear();
+		for (Force* f : acting)
+			view.acting.push_back(ViewOf(*f, nullptr));
+		view.torque = selectedBody->Torque(u_Time);
+	}
+	else {
+		snapshot.selected = BodyView();
+	}
+
+	snapshot.broadphase = world.GetBroadphase().GetType();
+	snapshot.threads = world.GetThreadCount();
+	snapshot.historyOnDisk = history != nullptr;
+	snapshot.recordingTolerance = recording_tolerance;
+
+	if (snapshot.plotWipes != plot_wipes) {
+		snapshot.plots.clear();
+		snapshot.plotWipes = plot_wipes;
+	}
+	for (const std::pair<std::shared_ptr<PhysicsBody>, PlotSeries::Quantity>& line : plotted)
+		snapshot.plots[line.first.get()].Update(*line.first, line.second);
 }
 
 void Sample3DSceneRenderer::OnDataObtained() {
@@ -308,83 +290,83 @@ void Sample3DSceneRenderer::Step() {
 	if (is_step) return;
 	is_step = true;
 
-	int i = 0;
-	for (std::shared_ptr<PhysicsBody> body1 : pBodies) {
-		int j = 0;
-		for (std::shared_ptr<PhysicsBody> body2 : pBodies) {
-			//make sure not to check collisions on the same object
-			if(i != j) {
-				//if body1 is colliding with body2
-				if (BoundingShape::IsColliding(body1->GetBounds(), body2->GetBounds())) {
-					
-					std::vector<XMFLOAT3> translations = BoundingShape::ResolveCollisions(body1->GetBounds(), body2->GetBounds());
-					body1->ApplyTranslation(translations[0]);
-					body2->ApplyTranslation(translations[1]);
-					
-					body1->RegisterCollision(body2, u_Time);
-					body2->RegisterCollision(body1, u_Time);
-				}
-			}
-			j++;
-		}
-		i++;
-	}
-	u_Time += 0.001f;
+	u_Time = world.Step(pBodies, u_Time);
 	if (u_Time >= latest_Time) {
 		latest_Time = u_Time;
 	}
-	for each (std::shared_ptr<PhysicsBody> body in pBodies) {
-		body->Step(u_Time);
-	}
 	is_step = false;
 }
 
-void Sample3DSceneRenderer::TimeManager() {
+void Sample3DSceneRenderer::TimeManager(const WorldSnapshot& snapshot) {
 	ImGui::Begin("Time manager");
 
 	if (ImGui::Button(is_stepping ? "Pause" : "Resume")) {
 		is_stepping = !is_stepping;
 	}
 	ImGui::SameLine();
+	ImGui::Checkbox("Real time", &real_time);
+	if (real_time) {
+		ImGui::SameLine();
+		ImGui::SetNextItemWidth(120);
+		ImGui::SliderFloat("x speed", &sim_speed, 0.01f, 10.0f, "%.2f", ImGuiSliderFlags_Logarithmic);
+		ImGui::SameLine();
+		ImGui::SetNextItemWidth(120);
+		ImGui::SliderInt("max steps per frame", &max_substeps, 1, 1000);
+	}
+	ImGui::SameLine();
+	std::ostringstream rateText;
+	rateText << "(" << (real_time ? "" : "as fast as possible, ") << physics->SimRate() << " sim s per s)";
+	ImGui::Text(rateText.str().c_str());
+
 	ImGui::Text("Time ="); ImGui::SameLine();
-	float timeBuf = u_Time;
+	float timeBuf = snapshot.time;
 	if (ImGui::InputFloat("s##Time", &timeBuf) && timeBuf >= 0) {
-		TimeJump(timeBuf);
+		physics->Submit([this, timeBuf] { ScrubTo(timeBuf); });
 	}
 	ImGui::SameLine();
 	std::ostringstream timeText;
-	timeText << "; Latest time = " << latest_Time << "s";
+	timeText << "; Latest time = " << snapshot.latestTime << "s";
 	ImGui::Text(timeText.str().c_str());
 	timeText.flush();
 	ImGui::SameLine();
 	if (ImGui::Button("Toggle grapher"))
 		is_graphing = !is_graphing;
 
-	int32_t currentFrame = u_Time * 1000;
+	int32_t shownFrame = (int32_t)(snapshot.time * 1000 + 0.5f);	//rounded, so the frame for a step isn't the one before it
+	int32_t currentFrame = shownFrame;
 	int32_t startFrame = 0;
-	int32_t endFrame = latest_Time >= 1.0f? latest_Time * 1000 : 1000;
+	int32_t endFrame = snapshot.latestTime >= 1.0f? snapshot.latestTime * 1000 : 1000;
 	if (ImGui::BeginNeoSequencer("Sequencer", &currentFrame, &startFrame, &endFrame)) {
-		if (!is_stepping && pBodies.size() > 1) {
-			TimeJump(currentFrame / 1000.0f);
+		//moving the sequencer's frame jumps there, once the physics thread gets to it
+		if (!is_stepping && snapshot.bodies.size() > 1 && currentFrame != shownFrame) {
+			float time = currentFrame / 1000.0f;
+			physics->Submit([this, time] { ScrubTo(time); });
 		}
-		int i = 0;
-		for(std::shared_ptr<PhysicsBody> b : pBodies) {
-			if (i > 0) {
-				std::vector<ImGui::FrameIndexType> keyframes;
-				for (std::shared_ptr<PEvent> e : b->GetEvents()) {
-					keyframes.push_back(e->GetStart() * 1000);
-				}
-				for (std::tuple<float, std::string> stamp : b->GetTimestamps()) {
-					keyframes.push_back(std::get<0>(stamp) * 1000);
-				}
-				if (ImGui::BeginNeoTimeline(b->GetName().c_str(), keyframes)) {
-					ImGui::EndNeoTimeLine();
-				}
-			} i++;
+		for (size_t i = 1; i < snapshot.timeline.size(); i++) {
+			keyframes = snapshot.timeline[i].keyframes;
+			if (ImGui::BeginNeoTimeline(snapshot.timeline[i].name.c_str(), keyframes)) {
+				ImGui::EndNeoTimeLine();
+			}
 		}
 		ImGui::EndNeoSequencer();
 	}
 
+	//what's acting now and what the last jump in time went past the start or end of, by body and event
+	const std::vector<EventSpan>* lists[] = { &snapshot.acting, &snapshot.passed };
+	const char* headings[] = { "Acting now: ", "Last jump passed: " };
+	for (int l = 0; l < 2; l++) {
+		std::ostringstream eventText;
+		eventText << headings[l];
+		for (const EventSpan& entry : *lists[l]) {
+			eventText << entry.body << ": " << entry.id << " (" << entry.start << "s to ";
+			if (entry.end == std::numeric_limits<float>::infinity())
+				eventText << "for good), ";
+			else
+				eventText << entry.end << "s), ";
+		}
+		ImGui::TextWrapped("%s", eventText.str().c_str());
+	}
+
 	ImGui::End();
 }
 
@@ -405,107 +387,206 @@ void Sample3DSceneRenderer::TimeJump(float time) {
 	}
 }
 
+void Sample3DSceneRenderer::ScrubTo(float time) {
+	float from = u_Time;
+	TimeJump(time);
+	if (u_Time != from) {
+		float t0 = from < u_Time ? from : u_Time;
+		float t1 = from < u_Time ? u_Time : from;
+		world.Events(pBodies).ChangesBetween(t0, t1, passedEvents);
+	}
+}
+
 void Sample3DSceneRenderer::TimeWipe() {
 	u_Time = latest_Time = 0;
 	for (std::shared_ptr<PhysicsBody> b : pBodies) {
-		b->GetTimeKeeper().Wipe({0, b->GetPosition(), b->GetRotation(), XMFLOAT3(), XMFLOAT3()});
+		b->GetTimeKeeper().SetHistoryFile(history);
+		b->GetTimeKeeper().SetRecordingTolerance(recording_tolerance);
+		b->GetTimeKeeper().Wipe({0, b->GetPosition(), b->GetRotation(), b->GetVelocity(), b->GetAngularVelocity()});
 		b->GetForces().clear();
 		b->GetTimestamps().clear();
 	}
+	//none of the bodies' history is in the file any more, so it can be written over
+	if (history)
+		history->Clear();
+	plot_wipes++;
+	world.ClearCheckpoints();
+	world.Checkpoint(pBodies, 0);
 }
 
-void Sample3DSceneRenderer::ObjectManager() {
+void Sample3DSceneRenderer::TimeRewrite(float from, std::function<void()> edit) {
+	//nothing before from has changed, so the bodies go back to the last checkpoint before it and are simulated again up to now.
+	//The step ending at from is worked out from what's acting at from, so the checkpoint has to be from before that step
+	float current = u_Time;
+	float to = (from < current ? from : current) - PhysicsWorld::STEP_SIZE;
+	float restored = world.Rewind(pBodies, to > 0 ? to : 0);
+	if (edit)
+		edit();
+	if (restored < 0) {
+		TimeWipe();
+		return;
+	}
+	u_Time = latest_Time = restored;
+	while (u_Time < current - PhysicsWorld::STEP_SIZE / 2) {
+		Step();
+	}
+}
+
+void Sample3DSceneRenderer::TimeOverride(std::shared_ptr<PhysicsBody> body) {
+	if (u_Time <= 0) {
+		TimeWipe();
+		return;
+	}
+	//bring the other bodies' forces and collisions up to now, then put the edited state back on top as the latest record
+	Record edited = { u_Time, body->GetPosition(), body->GetRotation(), body->GetVelocity(), body->GetAngularVelocity() };
+	TimeRewrite(u_Time);
+	if (u_Time < edited.time - PhysicsWorld::STEP_SIZE / 2)
+		return;		//there was no checkpoint to go back to, so everything was wiped and the edit is now the initial state
+	body->SetTransform(edited.position, edited.rotation, body->GetDimensions());
+	body->SetVelocity(edited.velocity);
+	body->SetAngVelocity(edited.ang_velocity);
+	body->GetTimeKeeper().Truncate(edited);
+	world.Checkpoint(pBodies, u_Time);
+}
+
+void Sample3DSceneRenderer::SetHistoryOnDisk(bool on) {
+	history = nullptr;
+	if (on) {
+		//each file gets its own name, as the last one stays open while any of the history is still in it
+		static int fileNumber = 0;
+		std::filesystem::path folder = std::wstring(Windows::Storage::ApplicationData::Current->TemporaryFolder->Path->Begin());
+		history = std::make_shared<HistoryFile>(folder / ("history" + std::to_string(fileNumber++) + ".bin"), true);
+		if (!history->IsOpen()) {
+			history = nullptr;
+			MessageBox(NULL, "The history file could not be created, so the history will be kept in memory", "History file error", MB_ICONWARNING | MB_OK);
+		}
+	}
+	for (std::shared_ptr<PhysicsBody> b : pBodies)
+		b->GetTimeKeeper().SetHistoryFile(history);
+}
+
+void Sample3DSceneRenderer::SetRecordingTolerance(float tolerance) {
+	//the history already recorded stays as it is, so there's nothing to simulate again
+	recording_tolerance = tolerance;
+	for (std::shared_ptr<PhysicsBody> b : pBodies)
+		b->GetTimeKeeper().SetRecordingTolerance(tolerance);
+}
+
+void Sample3DSceneRenderer::ObjectManager(const BodyView& view) {
 	ImGui::Begin("Object manager");
 
 	static char nameBuf[128];
-	for (int x = 0; x < selectedBody->GetName().length() + 1; x++) {
-		nameBuf[x] = selectedBody->GetName()[x];
+	for (int x = 0; x < view.name.length() + 1; x++) {
+		nameBuf[x] = view.name[x];
 	}
 	ImGui::Text("Name:"); ImGui::SameLine();
 	if (ImGui::InputText(" ", nameBuf, IM_ARRAYSIZE(nameBuf)) && !is_stepping) {
-		selectedBody->GiveName(nameBuf);
+		std::shared_ptr<PhysicsBody> body = view.body;
+		std::string name(nameBuf);
+		physics->Submit([body, name] { body->GiveName(name); });
 	}
 
 	ImGui::TextDisabled("(!)Before editing these properties...(!)");
 	if (ImGui::BeginItemTooltip()) {
 		ImGui::PushTextWrapPos(ImGui::GetFontSize() * 35.0f);
-		ImGui::TextUnformatted("Editing the below properties will erase the simulation!\n"
-								"The time values will be reset to 0 with the current state being set to the initial state!\n"
-								"Please ensure your timeline is set to 0s before making edits here!");
+		ImGui::TextUnformatted("Editing the position, rotation or velocities sets them at the current time, erasing the simulation after it!\n"
+								"Editing the mass, size or events simulates again from where they first make a difference, up to the current time.\n"
+								"To change the initial state, please ensure your timeline is set to 0s before making edits here!");
 		ImGui::PopTextWrapPos();
 		ImGui::EndTooltip();
 	}
 	
-	switch (selectedBody->GetType()) {
+	switch (view.body->GetType()) {
 	case PhysicsBody::Kinematic:
-		KinematicManager();
+		KinematicManager(view);
 		break;
 	}
 
 	ImGui::End();
 }
 
-void Sample3DSceneRenderer::KinematicManager() {
+void Sample3DSceneRenderer::KinematicManager(const BodyView& view) {
+	//shown from the snapshot, and edits are queued for the physics thread, which applies them between steps
+	std::shared_ptr<PhysicsBody> body = view.body;
 	ImGui::Text("Position(x, y, z):");
-	float posBuf[3] = { selectedBody->GetPosition().x, selectedBody->GetPosition().y, selectedBody->GetPosition().z };
+	float posBuf[3] = { view.position.x, view.position.y, view.position.z };
 	if (ImGui::InputFloat3("m##Pos", posBuf) && !is_stepping) {
-		selectedBody->SetTransform(XMFLOAT3(posBuf[0], posBuf[1], posBuf[2]), selectedBody->GetRotation(), selectedBody->GetDimensions());
-		TimeWipe();
+		XMFLOAT3 pos(posBuf[0], posBuf[1], posBuf[2]);
+		physics->Submit([this, body, pos] {
+			body->SetTransform(pos, body->GetRotation(), body->GetDimensions());
+			TimeOverride(body);
+		});
 	}
 
 	ImGui::Text("Rotation(roll, pitch, yaw):");
-	float rotBuf[3] = { selectedBody->GetRotation().x, selectedBody->GetRotation().z, selectedBody->GetRotation().y };
+	float rotBuf[3] = { view.rotation.x, view.rotation.z, view.rotation.y };
 	if (ImGui::DragFloat3("rad##Rot", rotBuf, 0.001f) && !is_stepping) {
-		selectedBody->SetTransform(selectedBody->GetPosition(), XMFLOAT3(rotBuf[0], rotBuf[2], rotBuf[1]), selectedBody->GetDimensions());
-		TimeWipe();
+		XMFLOAT3 rot(rotBuf[0], rotBuf[2], rotBuf[1]);
+		physics->Submit([this, body, rot] {
+			body->SetTransform(body->GetPosition(), rot, body->GetDimensions());
+			TimeOverride(body);
+		});
 	}
 
 	ImGui::Text("Velocity(x, y, z):");
-	float velBuf[3] = { selectedBody->GetVelocity().x, selectedBody->GetVelocity().y, selectedBody->GetVelocity().z };
+	float velBuf[3] = { view.velocity.x, view.velocity.y, view.velocity.z };
 	if (ImGui::InputFloat3("m/s##Vel", velBuf) && !is_stepping) {
-		selectedBody->SetVelocity(XMFLOAT3(velBuf[0], velBuf[1], velBuf[2]));
-		TimeWipe();
+		XMFLOAT3 vel(velBuf[0], velBuf[1], velBuf[2]);
+		physics->Submit([this, body, vel] {
+			body->SetVelocity(vel);
+			TimeOverride(body);
+		});
 	}
 
 	ImGui::Text("Angular velocity(roll, pitch, yaw):");
-	float angvelBuf[3] = { selectedBody->GetAngularVelocity().x, selectedBody->GetAngularVelocity().y, selectedBody->GetAngularVelocity().z };
+	float angvelBuf[3] = { view.angVelocity.x, view.angVelocity.y, view.angVelocity.z };
 	if (ImGui::InputFloat3("rad/s##AVel", angvelBuf) && !is_stepping) {
-		selectedBody->SetAngVelocity(XMFLOAT3(angvelBuf[0], angvelBuf[1], angvelBuf[2]));
-		TimeWipe();
+		XMFLOAT3 angvel(angvelBuf[0], angvelBuf[1], angvelBuf[2]);
+		physics->Submit([this, body, angvel] {
+			body->SetAngVelocity(angvel);
+			TimeOverride(body);
+		});
 	}
 
 	
-	float massBuf = selectedBody->GetMass();
+	float massBuf = view.mass;
 	ImGui::Text("Mass:"); ImGui::SameLine();
 	if (ImGui::InputFloat("kg", &massBuf, 0, 0, "%e") && !is_stepping) {
-		selectedBody->SetMass(massBuf);
-		TimeWipe();
+		physics->Submit([this, body, massBuf] {
+			body->SetMass(massBuf);
+			TimeRewrite(0);
+		});
 	}
 
-	switch (selectedBody->GetBounds()->GetType()) {
+	switch (view.bounds->GetType()) {
 	case BoundingShape::Cuboid:
 		ImGui::Text("Dimensions(x, y, z):");
 		{
-			float dimBuf[3] = { selectedBody->GetDimensions().x, selectedBody->GetDimensions().y, selectedBody->GetDimensions().z };
+			float dimBuf[3] = { view.dimensions.x, view.dimensions.y, view.dimensions.z };
 			if (ImGui::InputFloat3("m##DIMS", dimBuf) && !is_stepping) {
-				selectedBody->ApplyScale(XMFLOAT3(dimBuf[0], dimBuf[1], dimBuf[2]));
-				TimeWipe();
+				XMFLOAT3 dims(dimBuf[0], dimBuf[1], dimBuf[2]);
+				physics->Submit([this, body, dims] {
+					body->ApplyScale(dims);
+					TimeRewrite(0);
+				});
 			}
 		}
 		break;
 	case BoundingShape::Sphere:
 		ImGui::Text("Radius:");
 		{
-			float rBuf = selectedBody->GetDimensions().x;
+			float rBuf = view.dimensions.x;
 			if (ImGui::InputFloat("m##Radius", &rBuf) && !is_stepping) {
-				selectedBody->ApplyScale(XMFLOAT3(rBuf, rBuf, rBuf));
-				TimeWipe();
+				physics->Submit([this, body, rBuf] {
+					body->ApplyScale(XMFLOAT3(rBuf, rBuf, rBuf));
+					TimeRewrite(0);
+				});
 			}
 		}
 		break;
 	}
 	ImGui::Text("Resultant force(x, y, z):");
-	XMFLOAT3 rForces = Force::ResultantF(selectedBody->ActiveForces(u_Time)).GetDirection();
+	XMFLOAT3 rForces = view.resultant;
 	std::ostringstream rfor;
 	rfor << rForces.x << "N, " << rForces.y << "N, " << rForces.z << "N\n"
 		<< "  Magnitude: " << PhysMaths::Magnitude(rForces) << "N";
@@ -513,7 +594,7 @@ void Sample3DSceneRenderer::KinematicManager() {
 	rfor.flush();
 
 	ImGui::Text("Torque(roll, pitch, yaw):");
-	XMFLOAT3 torq = selectedBody->Torque(u_Time);
+	XMFLOAT3 torq = view.torque;
 	std::ostringstream torText;
 	torText << torq.x << "Nm, " << torq.z << "Nm, " << torq.y << "Nm\n"
 		<< "  Magnitude: " << PhysMaths::Magnitude(torq) << "Nm";
@@ -521,36 +602,41 @@ void Sample3DSceneRenderer::KinematicManager() {
 	torText.flush();
 
 	if (ImGui::CollapsingHeader("Pre-determined object events")) {
-		for (std::shared_ptr<PEvent> e : selectedBody->GetEvents()) {
-			if (ImGui::TreeNode(e->GetId().c_str())) {
+		for (const EventView& ev : view.events) {
+			std::shared_ptr<PEvent> e = ev.event;
+			//told apart by number, as two events can have the same ID
+			ImGui::PushID(ev.number);
+			if (ImGui::TreeNode(ev.id.c_str())) {
 				//handle object weight first, this is non-negotiable and a special case
-				if (e->GetId() == "Weight") {
-					ImGui::Text(e->GetId().c_str());
-					Force* eForce = dynamic_cast<Force*>(e.get()); //the weight will, no doubt, be of the Force type	
+				if (ev.id == "Weight") {
+					ImGui::Text(ev.id.c_str());
 					std::ostringstream oss;
-					oss << "Direction(x, y, z):" << eForce->GetDirection().x << "N, " << eForce->GetDirection().y << "N, " << eForce->GetDirection().z << "N\n"
-						<< "   Magnitude: " << eForce->Magnitude() << "N";
+					oss << "Direction(x, y, z):" << ev.direction.x << "N, " << ev.direction.y << "N, " << ev.direction.z << "N\n"
+						<< "   Magnitude: " << ev.magnitude << "N";
 					ImGui::Text(oss.str().c_str());
 					oss.flush();
 					std::ostringstream oss2;
-					oss2 << "Acting from(x,y,z): " << eForce->GetFrom().x << "m, " << eForce->GetFrom().y << "m, " << eForce->GetFrom().z << "m";
+					oss2 << "Acting from(x,y,z): " << ev.from.x << "m, " << ev.from.y << "m, " << ev.from.z << "m";
 					ImGui::Text(oss2.str().c_str());
 					oss2.flush();
 				}
 				else {
 					ImGui::Text("Event name:"); ImGui::SameLine();
 					char eNameBuf[128];
-					for (int x = 0; x < e->GetId().length() + 1; x++) {
-						eNameBuf[x] = e->GetId()[x];
+					for (int x = 0; x < ev.id.length() + 1; x++) {
+						eNameBuf[x] = ev.id[x];
 					}
 					if (ImGui::InputText("##EventName", eNameBuf, IM_ARRAYSIZE(eNameBuf)) && !is_stepping) {
-						e->SetId(eNameBuf);
+						std::string id(eNameBuf);
+						physics->Submit([e, id] { e->SetId(id); });
 					}
 
-					bool toggleBox = e->GetToggle();
+					bool toggleBox = ev.toggle;
 					if (ImGui::Checkbox("Toggle", &toggleBox) && !is_stepping) {
-						e->SetToggle(toggleBox);
-						TimeWipe();
+						physics->Submit([this, e, toggleBox] {
+							e->SetToggle(toggleBox);
+							TimeRewrite(e->GetStart());
+						});
 					}
 
 					const char* eventOptions[] = { "Force" };
@@ -558,65 +644,99 @@ void Sample3DSceneRenderer::KinematicManager() {
 					ImGui::Combo("Event type", &eOptionNum, eventOptions, 1);
 
 					ImGui::Text("Start time:"); ImGui::SameLine();
-					float eventTimeNum = e->GetStart();
+					float eventTimeNum = ev.start;
 					if (ImGui::InputFloat("s##EStartT", &eventTimeNum) && !is_stepping) {
-						e->SetStart(eventTimeNum);
-						TimeWipe();
+						physics->Submit([this, e, eventTimeNum] {
+							//the history is still right up to whichever start is earlier
+							float from = e->GetStart() < eventTimeNum ? e->GetStart() : eventTimeNum;
+							e->SetStart(eventTimeNum);
+							TimeRewrite(from);
+						});
 					}
 					//handle all other events
-					switch (e->GetEventType()) {
+					switch (ev.type) {
 					case PEvent::eventType::Force:
+						//only for the edits to be made on, the values shown are the snapshot's
 						Force* eForce = dynamic_cast<Force*>(e.get());
 						if (!eForce) { break; }
 						const char* ForceOptions[] = { "Constant", "Impulse" };
-						int forceTypeNum = eForce->GetForceType() == Force::Constant ? 0 : 1;
+						int forceTypeNum = ev.forceType == Force::Constant ? 0 : 1;
 						if (ImGui::Combo("Force type", &forceTypeNum, ForceOptions, 2) && !is_stepping) {
-							eForce->SetForceType(forceTypeNum == 0 ? Force::Constant : Force::Impulse);
-							TimeWipe();
+							Force::ForceType forceType = forceTypeNum == 0 ? Force::Constant : Force::Impulse;
+							physics->Submit([this, e, eForce, forceType] {
+								eForce->SetForceType(forceType);
+								TimeRewrite(e->GetStart());
+							});
 						}
-						if (eForce->GetForceType() == Force::Constant) {
+						if (ev.forceType == Force::Constant) {
 							ImGui::Text("End time:"); ImGui::SameLine();
-							float eventEndNum = e->GetEnd();
+							float eventEndNum = ev.end;
 							if (ImGui::InputFloat("s##EEndT", &eventEndNum) && !is_stepping) {
-								e->SetEnd(eventEndNum);
-								TimeWipe();
+								physics->Submit([this, e, eventEndNum] {
+									float from = e->GetEnd() < eventEndNum ? e->GetEnd() : eventEndNum;
+									e->SetEnd(eventEndNum);
+									TimeRewrite(from);
+								});
 							}
 						}
 						ImGui::Text("Direction(x, y, z):");
-						float eFBuf[3] = { eForce->GetDirection().x, eForce->GetDirection().y, eForce->GetDirection().z };
-						float eFBuf2 = eForce->Magnitude();
+						float eFBuf[3] = { ev.direction.x, ev.direction.y, ev.direction.z };
+						float eFBuf2 = ev.magnitude;
 						if (ImGui::InputFloat3("N##FORCEDIR", eFBuf) && !is_stepping) {
-							eForce->SetDirection(XMFLOAT3(eFBuf[0], eFBuf[1], eFBuf[2]));
-							TimeWipe();
+							XMFLOAT3 dir(eFBuf[0], eFBuf[1], eFBuf[2]);
+							physics->Submit([this, e, eForce, dir] {
+								eForce->SetDirection(dir);
+								TimeRewrite(e->GetStart());
+							});
 						}
 						ImGui::Text("Magnitude:"); ImGui::SameLine();
 						if (ImGui::InputFloat("N##FORCEMAG", &eFBuf2) && !is_stepping) {
-							eForce->SetDirection(PhysMaths::VecTimesByConstant(eForce->GetDirection(), eFBuf2 / eForce->Magnitude()));
-							TimeWipe();
+							physics->Submit([this, e, eForce, eFBuf2] {
+								eForce->SetDirection(PhysMaths::VecTimesByConstant(eForce->GetDirection(), eFBuf2 / eForce->Magnitude()));
+								TimeRewrite(e->GetStart());
+							});
 						}
 						ImGui::Text("Acting from(x, y, z):");
-						static float eFfromBuf0 = eForce->GetFrom().x, eFfromBuf1 = eForce->GetFrom().y, eFfromBuf2 = eForce->GetFrom().z;
+						static float eFfromBuf0 = ev.from.x, eFfromBuf1 = ev.from.y, eFfromBuf2 = ev.from.z;
 
 						if (ImGui::DragFloat("m##ActingFromX", &eFfromBuf0, 0.001f,
-							selectedBody->GetBounds()->GetMinPoint().x, selectedBody->GetBounds()->GetMaxPoint().x) && !is_stepping
-							&& BoundingShape::PointCollidingWithObject(XMFLOAT3(eFfromBuf0, eFfromBuf1, eFfromBuf2), selectedBody->GetBounds())
+							view.bounds->GetMinPoint().x, view.bounds->GetMaxPoint().x) && !is_stepping
+							&& BoundingShape::PointCollidingWithObject(XMFLOAT3(eFfromBuf0, eFfromBuf1, eFfromBuf2), view.bounds)
 							) {
-							eForce->SetFrom(XMFLOAT3(eFfromBuf0, eFfromBuf1, eFfromBuf2));
-							TimeWipe();
+							XMFLOAT3 from(eFfromBuf0, eFfromBuf1, eFfromBuf2);
+							physics->Submit([this, e, eForce, from] {
+								//the bodies are put back to a checkpoint first, so the point is moved by the same amount from where it was then
+								XMFLOAT3 offset = PhysMaths::Float3Minus(from, eForce->GetFrom());
+								TimeRewrite(e->GetStart(), [eForce, offset] {
+									eForce->SetFrom(PhysMaths::Float3Add(eForce->GetFrom(), offset));
+								});
+							});
 						}
 						if (ImGui::DragFloat("m##ActingFromY", &eFfromBuf1, 0.001f,
-							selectedBody->GetBounds()->GetMinPoint().y, selectedBody->GetBounds()->GetMaxPoint().y) && !is_stepping
-							&& BoundingShape::PointCollidingWithObject(XMFLOAT3(eFfromBuf0, eFfromBuf1, eFfromBuf2), selectedBody->GetBounds())
+							view.bounds->GetMinPoint().y, view.bounds->GetMaxPoint().y) && !is_stepping
+							&& BoundingShape::PointCollidingWithObject(XMFLOAT3(eFfromBuf0, eFfromBuf1, eFfromBuf2), view.bounds)
 							) {
-							eForce->SetFrom(XMFLOAT3(eFfromBuf0, eFfromBuf1, eFfromBuf2));
-							TimeWipe();
+							XMFLOAT3 from(eFfromBuf0, eFfromBuf1, eFfromBuf2);
+							physics->Submit([this, e, eForce, from] {
+								//the bodies are put back to a checkpoint first, so the point is moved by the same amount from where it was then
+								XMFLOAT3 offset = PhysMaths::Float3Minus(from, eForce->GetFrom());
+								TimeRewrite(e->GetStart(), [eForce, offset] {
+									eForce->SetFrom(PhysMaths::Float3Add(eForce->GetFrom(), offset));
+								});
+							});
 						}
 						if (ImGui::DragFloat("m##ActingFromZ", &eFfromBuf2, 0.001f,
-							selectedBody->GetBounds()->GetMinPoint().z, selectedBody->GetBounds()->GetMaxPoint().z) && !is_stepping
-							&& BoundingShape::PointCollidingWithObject(XMFLOAT3(eFfromBuf0, eFfromBuf1, eFfromBuf2), selectedBody->GetBounds())
+							view.bounds->GetMinPoint().z, view.bounds->GetMaxPoint().z) && !is_stepping
+							&& BoundingShape::PointCollidingWithObject(XMFLOAT3(eFfromBuf0, eFfromBuf1, eFfromBuf2), view.bounds)
 							) {
-							eForce->SetFrom(XMFLOAT3(eFfromBuf0, eFfromBuf1, eFfromBuf2));
-							TimeWipe();
+							XMFLOAT3 from(eFfromBuf0, eFfromBuf1, eFfromBuf2);
+							physics->Submit([this, e, eForce, from] {
+								//the bodies are put back to a checkpoint first, so the point is moved by the same amount from where it was then
+								XMFLOAT3 offset = PhysMaths::Float3Minus(from, eForce->GetFrom());
+								TimeRewrite(e->GetStart(), [eForce, offset] {
+									eForce->SetFrom(PhysMaths::Float3Add(eForce->GetFrom(), offset));
+								});
+							});
 						}
 
 						break;
@@ -624,115 +744,103 @@ void Sample3DSceneRenderer::KinematicManager() {
 				}
 				ImGui::TreePop();
 			}
+			ImGui::PopID();
 		}
 		if (ImGui::Button("Add new event") && !is_stepping) {
-			Force newEvent = Force(Force::Constant, XMFLOAT3());
-			newEvent.SetFrom(selectedBody->GetPosition());
-			newEvent.SetId("New event");
-			selectedBody->AddEvent(std::make_shared<Force>(newEvent));
-			TimeWipe();
+			physics->Submit([this, body] {
+				Force newEvent = Force(Force::Constant, XMFLOAT3());
+				newEvent.SetFrom(body->GetPosition());
+				newEvent.SetId("New event");
+				body->AddEvent(std::make_shared<Force>(newEvent));
+				TimeRewrite(newEvent.GetStart());
+			});
 		}
 	}
 	//handle events experienced in the specific instance in time
 	if (ImGui::CollapsingHeader("Current object events")) {
-		for (Force f : selectedBody->ActiveForces(u_Time)) {
-			if (ImGui::TreeNode(f.GetId().c_str())) {
+		for (const EventView& f : view.acting) {
+			ImGui::PushID(f.number);
+			if (ImGui::TreeNode(f.id.c_str())) {
 				ImGui::Text("Force name:"); ImGui::SameLine();
-				ImGui::Text(f.GetId().c_str());
+				ImGui::Text(f.id.c_str());
 				XMFLOAT3 torq = PhysMaths::Float3Cross(
-					XMFLOAT3(selectedBody->GetPosition().x - f.GetFrom().x,
-						selectedBody->GetPosition().y - f.GetFrom().y, selectedBody->GetPosition().z - f.GetFrom().z), f.GetDirection());
+					XMFLOAT3(view.position.x - f.from.x, view.position.y - f.from.y, view.position.z - f.from.z), f.direction);
 
 				std::ostringstream forceTxt;
-				forceTxt << "Direction(x, y, z): " << f.GetDirection().x << "N, " << f.GetDirection().y << "N, " << f.GetDirection().z << "N\n"
-					<< "   Magnitude: " << f.Magnitude() << "N\n"
-					<< "Acting from(x,y,z): " << f.GetFrom().x << "m, " << f.GetFrom().y << "m, " << f.GetFrom().z << "m\n"
+				forceTxt << "Direction(x, y, z): " << f.direction.x << "N, " << f.direction.y << "N, " << f.direction.z << "N\n"
+					<< "   Magnitude: " << f.magnitude << "N\n"
+					<< "Acting from(x,y,z): " << f.from.x << "m, " << f.from.y << "m, " << f.from.z << "m\n"
 					<< "Resulting torque(roll, pitch, yaw): \n" << torq.x << "Nm, " << torq.z << "Nm, " << torq.y << "Nm";
 				ImGui::Text(forceTxt.str().c_str());
 				forceTxt.flush();
 
 				ImGui::TreePop();
 			}
+			ImGui::PopID();
 		}
 	}
 
 }
 
-void Sample3DSceneRenderer::GraphPlotter() {
+void Sample3DSceneRenderer::GraphPlotter(WorldSnapshot& snapshot) {
 	ImGui::Begin("Graph plotter");
 
-	std::vector<float> timeVals;
-	timeVals.reserve(static_cast<size_t>((latest_Time / 0.001f) + 1));
-	for (float t = 0; t <= latest_Time; t += 0.001f)
-		timeVals.push_back(t);
-
-	std::vector<std::tuple<std::string, std::vector<float>>> yAxes;
-	int bI = 0;
-	for (std::shared_ptr<PhysicsBody> b : pBodies) {
-		if (bI > 0 && ImGui::TreeNode(b->GetName().c_str())) {
+	//the lines are worked out by the physics thread for each snapshot, only from the steps since it last had that snapshot
+	std::vector<std::tuple<std::string, PlotSeries*, PlotSeries::Quantity>> lines;
+	std::vector<std::pair<std::shared_ptr<PhysicsBody>, PlotSeries::Quantity>> wanted;
+	for (size_t bI = 1; bI < snapshot.bodies.size(); bI++) {
+		const std::shared_ptr<PhysicsBody>& b = snapshot.bodies[bI].body;
+		const std::string& name = snapshot.timeline[bI].name;
+		if (ImGui::TreeNode(name.c_str())) {
 			static bool displacement = false;
 			static bool speed = false;
 			static bool momentum = false;
 			static bool k_energy = false;
 			static bool gp_energy = false;
 
-			ImGui::Checkbox(("Plot displacement##" + b->GetName()).c_str(), &displacement);
-			ImGui::Checkbox(("Plot speed##" + b->GetName()).c_str(), &speed);
-			ImGui::Checkbox(("Plot momentum##" + b->GetName()).c_str(), &momentum);
-			ImGui::Checkbox(("Plot kinetic energy##" + b->GetName()).c_str(), &k_energy);
-			ImGui::Checkbox(("Plot relative gravitational potential energy##" + b->GetName()).c_str(), &gp_energy);
-
-			if (displacement) {
-				std::vector<float> dispY;
-				dispY.reserve(timeVals.size());
-				for (float t : timeVals) {
-					dispY.push_back(PhysMaths::Distance(b->GetTimeKeeper().Retrieve(0).position, b->GetTimeKeeper().Retrieve(t).position));
-				}
-				yAxes.push_back(std::make_tuple(("Displacement of " + b->GetName() + "(m)"), std::move(dispY)));
-			}
-			if (speed) {
-				std::vector<float> speedY;
-				speedY.reserve(timeVals.size());
-				for (float t : timeVals) {
-					speedY.push_back(PhysMaths::Magnitude(b->GetTimeKeeper().Retrieve(t).velocity));
-				}
-				yAxes.push_back(std::make_tuple(("Speed of " + b->GetName() + "(m/s)"), std::move(speedY)));
-			}
-			if (momentum) {
-				std::vector<float> momY;
-				momY.reserve(timeVals.size());
-				for (float t : timeVals) {
-					momY.push_back(PhysMaths::Magnitude(b->GetTimeKeeper().Retrieve(t).velocity) * b->GetMass());
-				}
-				yAxes.push_back(std::make_tuple(("Momentum of " + b->GetName() + "(kg m/s)"), std::move(momY)));
-			}
-			if (k_energy) {
-				std::vector<float> kinY;
-				kinY.reserve(timeVals.size());
-				for (float t : timeVals) {
-					kinY.push_back((0.5f * b->GetMass() * pow(PhysMaths::Magnitude(b->GetTimeKeeper().Retrieve(t).velocity), 2))
-									+ (0.5f * b->GetMass() * pow(PhysMaths::Magnitude(b->GetTimeKeeper().Retrieve(t).ang_velocity), 2)));
-				}
-				yAxes.push_back(std::make_tuple(("Kinetic energy of " + b->GetName() + "(J)"), std::move(kinY)));
-			}
-			if (gp_energy) {
-				std::vector<float> gravY;
-				gravY.reserve(timeVals.size());
-				for (float t : timeVals) {
-					gravY.push_back(b->GetMass() * 9.81f *  b->GetTimeKeeper().Retrieve(t).position.y);
-				}
-				yAxes.push_back(std::make_tuple(("Relative GPE of " + b->GetName() + "(J)"), std::move(gravY)));
-			}
+			ImGui::Checkbox(("Plot displacement##" + name).c_str(), &displacement);
+			ImGui::Checkbox(("Plot speed##" + name).c_str(), &speed);
+			ImGui::Checkbox(("Plot momentum##" + name).c_str(), &momentum);
+			ImGui::Checkbox(("Plot kinetic energy##" + name).c_str(), &k_energy);
+			ImGui::Checkbox(("Plot relative gravitational potential energy##" + name).c_str(), &gp_energy);
+
+			auto plot = [&](bool checked, PlotSeries::Quantity quantity, std::string label) {
+				if (!checked)
+					return;
+				wanted.push_back(std::make_pair(b, quantity));
+				//a line just asked for isn't drawn until a snapshot has it worked out for every step
+				std::map<PhysicsBody*, PlotSeries>::iterator series = snapshot.plots.find(b.get());
+				if (series != snapshot.plots.end() && series->second.Get(quantity).size() == series->second.GetTimes().size())
+					lines.push_back(std::make_tuple(label, &series->second, quantity));
+			};
+			plot(displacement, PlotSeries::Displacement, "Displacement of " + name + "(m)");
+			plot(speed, PlotSeries::Speed, "Speed of " + name + "(m/s)");
+			plot(momentum, PlotSeries::Momentum, "Momentum of " + name + "(kg m/s)");
+			plot(k_energy, PlotSeries::KineticEnergy, "Kinetic energy of " + name + "(J)");
+			plot(gp_energy, PlotSeries::GravitationalPE, "Relative GPE of " + name + "(J)");
 			ImGui::TreePop();
 		}
-		bI++;
+	}
+	if (wanted != plot_request) {
+		plot_request = wanted;
+		physics->Submit([this, wanted] { plotted = wanted; });
 	}
 
+	//largest triangle keeps the shape of the line better, min/max makes sure no spike is missed
+	bool triangles = plot_method == SeriesPyramid::LargestTriangle;
+	if (ImGui::Checkbox("Largest triangle decimation", &triangles))
+		plot_method = triangles ? SeriesPyramid::LargestTriangle : SeriesPyramid::MinMax;
+
 	if (ImPlot::BeginPlot("Graph 1")) {
 		ImPlot::SetupAxes("Time(s)", "Quantity(units)");
-		ImPlot::SetNextMarkerStyle(ImPlotMarker_None);
-		for (const auto& yVals : yAxes) {
-			ImPlot::PlotLine(std::get<0>(yVals).c_str(), timeVals.data(), std::get<1>(yVals).data(), timeVals.size());
+		//only about as many points as the plot is wide are drawn, picked from the part of each line in view
+		ImPlotRect limits = ImPlot::GetPlotLimits();
+		int pixels = (int)ImPlot::GetPlotSize().x;
+		std::vector<float> xs, ys;
+		for (const auto& line : lines) {
+			std::get<1>(line)->Decimate(std::get<2>(line), limits.X.Min, limits.X.Max, pixels, plot_method, xs, ys);
+			ImPlot::SetNextMarkerStyle(ImPlotMarker_None);
+			ImPlot::PlotLine(std::get<0>(line).c_str(), xs.data(), ys.data(), (int)xs.size());
 		}
 		ImPlot::EndPlot();
 	}
@@ -747,9 +855,15 @@ void Sample3DSceneRenderer::Render() {
 	ImGui_ImplDX11_NewFrame();
 	ImGui::NewFrame();
 
+	//everything is drawn from the physics thread's latest snapshot, so a frame never waits for a step. Edits are queued for
+	//the physics thread, the few made here take the world lock for just as long as they take
+	WorldSnapshot& snapshot = physics->LatestSnapshot();
+
 	if (ImGui::BeginMainMenuBar()) {
 		if (ImGui::BeginMenu("PhysicsCanvas")) {
 			if (ImGui::MenuItem("Return to library")) {
+				is_stepping = false;
+				physics->SetRunning(false);
 				data_obtained = false;
 				library->Refresh();
 			}
@@ -775,6 +889,36 @@ void Sample3DSceneRenderer::Render() {
 				ImGui::Text("Coming soon!");
 				ImGui::EndMenu();
 			}
+			if (ImGui::BeginMenu("Collision broadphase")) {
+				//the AABB tree also speeds up picking, the spatial hash is quicker for piles of many similarly sized bodies
+				if (ImGui::MenuItem("Dynamic AABB tree", nullptr, snapshot.broadphase == Broadphase::DynamicTree))
+					physics->Submit([this] { world.SetBroadphase(Broadphase::DynamicTree); });
+				if (ImGui::MenuItem("Sweep and prune", nullptr, snapshot.broadphase == Broadphase::SweepPrune))
+					physics->Submit([this] { world.SetBroadphase(Broadphase::SweepPrune); });
+				if (ImGui::MenuItem("Spatial hash grid", nullptr, snapshot.broadphase == Broadphase::SpatialHash))
+					physics->Submit([this] { world.SetBroadphase(Broadphase::SpatialHash); });
+				ImGui::EndMenu();
+			}
+			if (ImGui::BeginMenu("Physics threads")) {
+				//results are the same for any number of threads, only the speed changes
+				int threads = (int)snapshot.threads;
+				int maxThreads = (int)std::thread::hardware_concurrency();
+				ImGui::SliderInt("##threads", &threads, 1, maxThreads > 1 ? maxThreads : 1);
+				if (ImGui::IsItemDeactivatedAfterEdit())
+					physics->Submit([this, threads] { world.SetThreadCount(threads); });
+				ImGui::EndMenu();
+			}
+			//for simulations too long for their history to fit in memory
+			if (ImGui::MenuItem("Keep history on disk", nullptr, snapshot.historyOnDisk))
+				physics->Submit([this] { SetHistoryOnDisk(history == nullptr); });
+			if (ImGui::BeginMenu("History recording")) {
+				//bodies at rest or in free flight only need a step kept every so often, 0 keeps every step
+				float tolerance = snapshot.recordingTolerance;
+				ImGui::InputFloat("tolerance##Recording", &tolerance, 0, 0, "%e");
+				if (ImGui::IsItemDeactivatedAfterEdit() && tolerance >= 0)
+					physics->Submit([this, tolerance] { SetRecordingTolerance(tolerance); });
+				ImGui::EndMenu();
+			}
 			ImGui::EndMenu();
 		}
 		ImGui::EndMainMenuBar();
@@ -783,49 +927,49 @@ void Sample3DSceneRenderer::Render() {
 	XMMATRIX viewMat = XMMatrixLookAtRH(
 		XMLoadFloat3(&controller->get_Position()), XMLoadFloat3(&controller->get_LookPoint()), up);
 
-	for (std::shared_ptr<PhysicsBody> body : pBodies) {
-		body->Render(viewMat * projectionMat);
+	//a body added or removed since the snapshot shows up or goes with the next one
+	for (const BodyTransform& t : snapshot.bodies) {
+		t.body->GetMesh().SetWorldMat(t.position, t.rotation, t.dimensions);
+		t.body->Render(viewMat * projectionMat);
 	}
 	
 	ImGui::SetNextWindowPos(ImVec2(12, 60));
-	ImGui::SetNextWindowSize(ImVec2(170, 50 * (pBodies.size() + 1) > 120? 120 : 50 * (pBodies.size() + 1)));
+	ImGui::SetNextWindowSize(ImVec2(170, 50 * (snapshot.bodies.size() + 1) > 120? 120 : 50 * (snapshot.bodies.size() + 1)));
 	ImGui::Begin("All objects");
-	int i = 0;
-	for (std::shared_ptr<PhysicsBody> b : pBodies) {
-		if (i > 0) {
-			if (ImGui::Button(b->GetName() != "" ? b->GetName().c_str() : "##Empty label")) {
-				selectedBody = b;
-			}
+	for (size_t i = 1; i < snapshot.bodies.size(); i++) {
+		const std::string& name = snapshot.timeline[i].name;
+		if (ImGui::Button(name != "" ? name.c_str() : "##Empty label")) {
+			std::shared_ptr<PhysicsBody> b = snapshot.bodies[i].body;
+			physics->Submit([this, b] { selectedBody = b; });
 		}
-		i++;
 	}
-	if (i == 1)
+	if (snapshot.bodies.size() == 1)
 		ImGui::TextWrapped("Go to Edit to add a new object");
 	ImGui::End();
 
 	ImGui::SetNextWindowPos(ImVec2(12, m_deviceResources->GetOutputSize().Height * 0.68f));
 	ImGui::SetNextWindowSize(ImVec2(m_deviceResources->GetOutputSize().Width * 0.95f, m_deviceResources->GetOutputSize().Height * 0.275f));
-	TimeManager();
+	TimeManager(snapshot);
 
-	if (selectedBody != nullptr) {
-		ObjectManager();
+	if (snapshot.hasSelected) {
+		ObjectManager(snapshot.selected);
 
-		for (Force& f : selectedBody->ActiveForces(u_Time)) {
+		for (const EventView& f : snapshot.selected.acting) {
 			ArrowMesh arr;
-			arr.Create(m_deviceResources, f.GetColour());
+			arr.Create(m_deviceResources, f.colour);
 			XMFLOAT3 rot(0,0,0);
-			rot.x = atanf(f.GetDirection().y / PhysMaths::Magnitude(XMFLOAT3(f.GetDirection().x, 0, f.GetDirection().z)));
-			rot.y = f.GetDirection().x == 0 && f.GetDirection().z == 0? 0
-				: acosf(PhysMaths::Float3Dot(XMFLOAT3(f.GetDirection().x, 0, f.GetDirection().z), XMFLOAT3(0,0,1))
-					/ PhysMaths::Magnitude(XMFLOAT3(f.GetDirection().x, 0, f.GetDirection().z)));
-			arr.SetWorldMat(f.GetFrom(), rot, 0.01f * f.Magnitude());
+			rot.x = atanf(f.direction.y / PhysMaths::Magnitude(XMFLOAT3(f.direction.x, 0, f.direction.z)));
+			rot.y = f.direction.x == 0 && f.direction.z == 0? 0
+				: acosf(PhysMaths::Float3Dot(XMFLOAT3(f.direction.x, 0, f.direction.z), XMFLOAT3(0,0,1))
+					/ PhysMaths::Magnitude(XMFLOAT3(f.direction.x, 0, f.direction.z)));
+			arr.SetWorldMat(f.from, rot, 0.01f * f.magnitude);
 			arr.Render(viewMat * projectionMat);
 			arr.ReleaseResources();
 		}
 	}
 
 	if (is_graphing) {
-		GraphPlotter();
+		GraphPlotter(snapshot);
 	}
 	
 	ImGui::Render();
@@ -834,6 +978,8 @@ void Sample3DSceneRenderer::Render() {
 }
 
 void Sample3DSceneRenderer::CreateNewMesh(const UINT shape) {
+	//the new body is placed against the others, so they're held still until it's in
+	std::lock_guard<std::recursive_mutex> lock(physics->WorldLock());
 	PhysicsBody nbody;
 	nbody.Create(shape, m_deviceResources);
 	std::string name;
@@ -866,39 +1012,38 @@ void Sample3DSceneRenderer::CreateNewMesh(const UINT shape) {
 	XMVECTOR rayOrigin, rayDir;
 	rayOriginScreen = XMVectorSet(display.Width / 2.0f, display.Height / 2.0f, 0.1f, 1.0f);
 	rayDirScreen = XMVectorSet(display.Width / 2.0f, display.Height / 2.0f, 1.0f, 1.0f);
-	
-	XMFLOAT3 newpos;
-	for (std::shared_ptr<PhysicsBody> body : pBodies) {
-		rayOrigin = XMVector3Unproject(rayOriginScreen, 0, 0, display.Width, display.Height, 0, 1, projectionMat, viewMat, body->GetMesh().GetWorldMat());
-		rayDir = XMVector3Unproject(rayDirScreen, 0, 0, display.Width, display.Height, 0, 1, projectionMat, viewMat, body->GetMesh().GetWorldMat());
-		rayDir = XMVector3Normalize(rayDir - rayOrigin);
-		XMFLOAT3 direction;
-		XMStoreFloat3(&direction, rayDir);
-		XMFLOAT3 point;
-		for (float proportion = 0.05f; proportion < 30.0f; proportion += 0.05f) {
-			point = { controller->get_Position().x + proportion * direction.x,
-					controller->get_Position().y + proportion * direction.y,
-					controller->get_Position().z + proportion * direction.z };
-			newpos = point;
-			if (BoundingShape::PointCollidingWithObject(point, body->GetBounds())) {
-				nbody.ApplyTranslation(newpos);
-				std::vector<XMFLOAT3> translations = BoundingShape::ResolveCollisions(nbody.GetBounds(), body->GetBounds());
-				newpos = { newpos.x + translations[0].x - translations[1].x,
-						newpos.y + translations[0].y - translations[1].y,
-						newpos.z + translations[0].z - translations[1].z };
-				nbody.SetTransform(newpos, nbody.GetRotation(), nbody.GetDimensions());
-				std::shared_ptr<PhysicsBody> nbodyPointer = std::make_shared<PhysicsBody>(nbody);
-				selectedBody = nbodyPointer;
-				pBodies.push_back(nbodyPointer);
-				TimeWipe();
-				return;
-			}
-		}	
+	rayOrigin = XMVector3Unproject(rayOriginScreen, 0, 0, display.Width, display.Height, 0, 1, projectionMat, viewMat, XMMatrixIdentity());
+	rayDir = XMVector3Unproject(rayDirScreen, 0, 0, display.Width, display.Height, 0, 1, projectionMat, viewMat, XMMatrixIdentity());
+	rayDir = XMVector3Normalize(rayDir - rayOrigin);
+	XMFLOAT3 direction;
+	XMStoreFloat3(&direction, rayDir);
+
+	//place the new body where the ray first hits something
+	int hitBody = -1;
+	float hitDist = 30.0f;
+	XMFLOAT3 hitNormal;
+	RaycastBodies(controller->get_Position(), direction, hitDist, false, hitBody, hitDist, hitNormal);
+
+	XMFLOAT3 newpos = PhysMaths::Float3Add(controller->get_Position(), PhysMaths::VecTimesByConstant(direction, hitDist));
+	if (hitBody != -1) {
+		std::shared_ptr<PhysicsBody> body = world.GetBroadphase().GetBody(hitBody);
+		nbody.ApplyTranslation(newpos);
+		std::array<XMFLOAT3, 2> translations = BoundingShape::ResolveCollisions(nbody.GetBounds(), body->GetBounds());
+		newpos = { newpos.x + translations[0].x - translations[1].x,
+				newpos.y + translations[0].y - translations[1].y,
+				newpos.z + translations[0].z - translations[1].z };
+		nbody.SetTransform(newpos, nbody.GetRotation(), nbody.GetDimensions());
+		std::shared_ptr<PhysicsBody> nbodyPointer = std::make_shared<PhysicsBody>(nbody);
+		selectedBody = nbodyPointer;
+		pBodies.push_back(nbodyPointer);
+		TimeWipe();
+		physics->Refresh();
+		return;
 	}
 	nbody.ApplyTranslation(newpos);
 	for (std::shared_ptr<PhysicsBody> body : pBodies) {
 		if(BoundingShape::IsColliding(nbody.GetBounds(), body->GetBounds())) {
-			std::vector<XMFLOAT3> translations = BoundingShape::ResolveCollisions(nbody.GetBounds(), body->GetBounds());
+			std::array<XMFLOAT3, 2> translations = BoundingShape::ResolveCollisions(nbody.GetBounds(), body->GetBounds());
 			newpos = { newpos.x + translations[0].x - translations[1].x,
 					abs(newpos.y + translations[0].y - translations[1].y),
 					newpos.z + translations[0].z - translations[1].z };
@@ -909,6 +1054,7 @@ void Sample3DSceneRenderer::CreateNewMesh(const UINT shape) {
 	selectedBody = nbodyPointer;
 	pBodies.push_back(nbodyPointer);
 	TimeWipe();
+	physics->Refresh();
 }
 
 void Sample3DSceneRenderer::RaycastFromClick(float x, float y) {
@@ -925,48 +1071,67 @@ void Sample3DSceneRenderer::RaycastFromClick(float x, float y) {
 	XMVECTOR rayOrigin, rayDir;
 	rayOriginScreen = XMVectorSet(x, y, 0.1f, 1.0f);
 	rayDirScreen = XMVectorSet(x, y, 1.0f, 1.0f);
+	rayOrigin = XMVector3Unproject(rayOriginScreen, 0, 0, display.Width, display.Height, 0, 1, projectionMat, viewMat, XMMatrixIdentity());
+	rayDir = XMVector3Unproject(rayDirScreen, 0, 0, display.Width, display.Height, 0, 1, projectionMat, viewMat, XMMatrixIdentity());
+	rayDir = XMVector3Normalize(rayDir - rayOrigin);
+
+	XMFLOAT3 direction;
+	XMStoreFloat3(&direction, rayDir);
+
+	//select the nearest body under the cursor, the floor can't be selected. The ray is cast by the physics thread, as it
+	//goes through the broadphase
+	XMFLOAT3 origin = controller->get_Position();
+	physics->Submit([this, origin, direction] {
+		int hitBody = -1;
+		float hitDist;
+		XMFLOAT3 hitNormal;
+		if (RaycastBodies(origin, direction, 100.0f, true, hitBody, hitDist, hitNormal))
+			selectedBody = world.GetBroadphase().GetBody(hitBody);
+		else
+			selectedBody = nullptr;
+	});
+	already_casting = false;
+}
 
-	int i = 0;
-	for (std::shared_ptr<PhysicsBody> body : pBodies) {
-		if(i > 0) {
-			rayOrigin = XMVector3Unproject(rayOriginScreen, 0, 0, display.Width, display.Height, 0, 1, projectionMat, viewMat, body->GetMesh().GetWorldMat());
-			rayDir = XMVector3Unproject(rayDirScreen, 0, 0, display.Width, display.Height, 0, 1, projectionMat, viewMat, body->GetMesh().GetWorldMat());
-			rayDir = XMVector3Normalize(rayDir - rayOrigin);
-
-			XMFLOAT3 direction;
-			XMStoreFloat3(&direction, rayDir);
-
-			XMFLOAT3 point;
-			for (float proportion = 0.05f; proportion < 100.0f; proportion += 0.05f) {
-				point = { controller->get_Position().x + proportion * direction.x,
-						controller->get_Position().y + proportion * direction.y,
-						controller->get_Position().z + proportion * direction.z };
-
-				if (BoundingShape::PointCollidingWithObject(point, body->GetBounds())) {
-					selectedBody = body;
-					already_casting = false;
-					return;
-				}
-			}
+bool Sample3DSceneRenderer::RaycastBodies(XMFLOAT3 origin, XMFLOAT3 dir, float maxDist, bool skipFloor, int& hitBody, float& hitDist, XMFLOAT3& hitNormal) {
+	//the broadphase narrows it down to bodies whose bounding box is on the ray, then the exact shapes are tested
+	world.GetBroadphase().Update(pBodies);
+	std::vector<int> candidates;
+	world.GetBroadphase().RayQuery(origin, dir, maxDist, candidates);
+
+	hitBody = -1;
+	float nearest = maxDist;
+	for (int i : candidates) {
+		//the floor is always first in the list
+		if (skipFloor && i == 0)
+			continue;
+		float dist;
+		XMFLOAT3 normal;
+		if (world.GetBroadphase().GetBody(i)->GetBounds()->RayIntersect(origin, dir, nearest, dist, normal)) {
+			hitBody = i;
+			nearest = dist;
+			hitDist = dist;
+			hitNormal = normal;
 		}
-		i++;
 	}
-	selectedBody = nullptr;
-	already_casting = false;
+	return hitBody != -1;
 }
 
 void Sample3DSceneRenderer::CreateDeviceDependentResources()
 {
 	if (!data_obtained) return library->CreateDeviceDependentResources();
 
+	std::lock_guard<std::recursive_mutex> lock(physics->WorldLock());
 	//create the floor of the world
 	PhysicsBody floor;
 	floor.Create(FLOOR, m_deviceResources);
 	floor.GiveName("FLOOR");
 	pBodies.push_front(std::make_shared<PhysicsBody>(floor));
+	physics->Refresh();
 }
 
 void Sample3DSceneRenderer::ReleaseDeviceDependentResources() {
+	std::lock_guard<std::recursive_mutex> lock(physics->WorldLock());
 	for each (std::shared_ptr<PhysicsBody> body in pBodies) {
 		body->ReleaseResources();
 	}
@@ -7,7 +7,12 @@
 #include "..\Common\DirectXHelper.h"
 #include "MoveLookControls.h"
 #include "PhysicsBody.h"
+#include "PhysicsWorld.h"
+#include "SimFile.h"
+#include "PhysicsThread.h"
+#include "PlotSeries.h"
 #include <list>
+#include <map>
 #include "..\ImGUI\imgui.h"
 #include "..\ImGUI\imgui_impl_win32.h"
 #include "..\ImGUI\imgui_impl_dx11.h"
@@ -30,14 +35,27 @@ namespace PhysicsCanvas
 		void Render();
 		void CreateNewMesh(const UINT shape);
 		void RaycastFromClick(float x, float y);
+		bool RaycastBodies(DirectX::XMFLOAT3 origin, DirectX::XMFLOAT3 dir, float maxDist, bool skipFloor, int& hitBody, float& hitDist, DirectX::XMFLOAT3& hitNormal);
 
-		void ObjectManager();
-		void KinematicManager();
+		// The panels are drawn from the physics thread's latest snapshot, and their edits queued for it
+		void ObjectManager(const BodyView& view);
+		void KinematicManager(const BodyView& view);
 
-		void TimeManager();
-		void GraphPlotter();
+		void TimeManager(const WorldSnapshot& snapshot);
+		void GraphPlotter(WorldSnapshot& snapshot);
 		void TimeWipe();
+		// An edit that changes what happens from time from on: the history before it is kept and the rest simulated again.
+		// edit, if there is one, is made after the bodies are put back to the checkpoint the simulation restarts from
+		void TimeRewrite(float from, std::function<void()> edit = nullptr);
+		// body's current state has been edited: the history up to now is kept and everything after it dropped
+		void TimeOverride(std::shared_ptr<PhysicsBody> body);
+		// Moves the history of the simulation from now on into a temporary file, or back into memory
+		void SetHistoryOnDisk(bool on);
+		// Only keeps the steps recorded from now on that can't be worked out to within tolerance from the ones kept before them
+		void SetRecordingTolerance(float tolerance);
 		void TimeJump(float time);
+		// Jumps to time from the time manager, noting the events it goes past the start or end of
+		void ScrubTo(float time);
 
 		void Step();
 	
@@ -54,6 +72,12 @@ namespace PhysicsCanvas
 		bool is_revStepping;
 
 		bool is_graphing;
+
+		// Real time stepping: sim_speed is how many simulated seconds to run per wall-clock second, otherwise the physics runs
+		// as fast as it can. max_substeps caps the steps between snapshots.
+		bool real_time = true;
+		float sim_speed = 1.0f;
+		int max_substeps = 100;
 	private:
 		// Cached pointer to device resources.
 		std::shared_ptr<DX::DeviceResources> m_deviceResources;
@@ -62,9 +86,34 @@ namespace PhysicsCanvas
 		std::list<std::shared_ptr<PhysicsBody>> pBodies;
 		std::shared_ptr<PhysicsBody> selectedBody = nullptr;
 
+		// Collision broadphase and worker threads used to step the bodies
+		PhysicsWorld world;
+
+		// Where the bodies' history goes if it's kept on disk, null if it's kept in memory
+		std::shared_ptr<HistoryFile> history;
+		float recording_tolerance = 0;
+
+		// The lines the graph plotter has asked for, which the physics thread works out for each snapshot. A TimeWipe() bumps
+		// plot_wipes, so the snapshots drop what they'd worked out before. plot_request is the UI's copy of what it last asked for
+		std::vector<std::pair<std::shared_ptr<PhysicsBody>, PlotSeries::Quantity>> plotted;
+		unsigned int plot_wipes = 0;
+		std::vector<std::pair<std::shared_ptr<PhysicsBody>, PlotSeries::Quantity>> plot_request;
+		SeriesPyramid::Method plot_method = SeriesPyramid::MinMax;
+
+		// A body's keyframes for the sequencer, copied from the snapshot as the sequencer takes them to edit
+		std::vector<int32_t> keyframes;
+		// The events acting at the current time and those the last jump in time went past the start or end of, from the
+		// world's event index
+		std::vector<EventIndex::Entry> actingEvents;
+		std::vector<EventIndex::Entry> passedEvents;
+
 		bool already_casting = false;
 		bool is_step = false;
 		bool is_filing = false;
+
+		// Steps the bodies in the background. Declared after everything a step uses, so it stops before any of it is destroyed
+		std::unique_ptr<PhysicsThread> physics;
+		void TakeSnapshot(WorldSnapshot& snapshot);
 	private:
 		std::unique_ptr<ProjectLib> library;
 		bool data_obtained;
@@ -0,0 +1,110 @@
+#include "EventIndex.h"
+#include <algorithm>
+#include <limits>
+
+using namespace PhysicsCanvas;
+
+static bool StartsBefore(const EventIndex::Entry& a, const EventIndex::Entry& b) {
+	if (a.start != b.start)
+		return a.start < b.start;
+	return a.body < b.body || (a.body == b.body && a.event < b.event);
+}
+
+void EventIndex::Sync(std::list<std::shared_ptr<PhysicsBody>>& bodies) {
+	bool changed = bodies.size() != synced.size();
+	size_t i = 0;
+	for (std::list<std::shared_ptr<PhysicsBody>>::iterator b = bodies.begin(); !changed && b != bodies.end(); b++, i++)
+		changed = synced[i].first != b->get() || synced[i].second != (*b)->GetEventRevision();
+	if (!changed)
+		return;
+
+	synced.clear();
+	entries.clear();
+	bodyStarts.clear();
+	int body = 0;
+	for (const std::shared_ptr<PhysicsBody>& b : bodies) {
+		synced.push_back({ b.get(), b->GetEventRevision() });
+		bodyStarts.emplace_back();
+		const std::vector<Force*>& forces = b->GetForceEvents();
+		for (int e = 0; e < (int)forces.size(); e++) {
+			bool forGood = forces[e]->GetForceType() == Force::Weight;
+			entries.push_back({ forces[e]->GetStart(), forGood ? std::numeric_limits<float>::infinity() : forces[e]->GetEnd(), body, e });
+			bodyStarts.back().push_back(forces[e]->GetStart());
+		}
+		std::sort(bodyStarts.back().begin(), bodyStarts.back().end());
+		body++;
+	}
+	std::sort(entries.begin(), entries.end(), StartsBefore);
+
+	//the sorted entries are an implicit balanced tree, the middle of each range being the parent of the middles of its halves
+	maxEnd.assign(entries.size(), 0);
+	struct Range {
+		size_t lo, hi;
+		bool halvesDone;
+	};
+	std::vector<Range> pending;
+	if (!entries.empty())
+		pending.push_back({ 0, entries.size(), false });
+	while (!pending.empty()) {
+		Range r = pending.back();
+		size_t mid = (r.lo + r.hi) / 2;
+		if (!r.halvesDone) {
+			pending.back().halvesDone = true;
+			if (r.lo < mid)
+				pending.push_back({ r.lo, mid, false });
+			if (mid + 1 < r.hi)
+				pending.push_back({ mid + 1, r.hi, false });
+			continue;
+		}
+		pending.pop_back();
+		float latest = entries[mid].end;
+		if (r.lo < mid)
+			latest = std::max(latest, maxEnd[(r.lo + mid) / 2]);
+		if (mid + 1 < r.hi)
+			latest = std::max(latest, maxEnd[(mid + 1 + r.hi) / 2]);
+		maxEnd[mid] = latest;
+	}
+
+	byEnd.resize(entries.size());
+	for (size_t e = 0; e < entries.size(); e++)
+		byEnd[e] = (int)e;
+	std::sort(byEnd.begin(), byEnd.end(), [this](int a, int b) {
+		return entries[a].end < entries[b].end || (entries[a].end == entries[b].end && a < b);
+	});
+}
+
+void EventIndex::Stab(size_t lo, size_t hi, float time, std::vector<Entry>& active) const {
+	if (lo >= hi)
+		return;
+	size_t mid = (lo + hi) / 2;
+	//nothing under here is still acting
+	if (maxEnd[mid] <= time)
+		return;
+	Stab(lo, mid, time, active);
+	//everything from mid on starts after time
+	if (entries[mid].start > time)
+		return;
+	if (entries[mid].end > time)
+		active.push_back(entries[mid]);
+	Stab(mid + 1, hi, time, active);
+}
+
+void EventIndex::ActiveAt(float time, std::vector<Entry>& active) const {
+	active.clear();
+	Stab(0, entries.size(), time, active);
+}
+
+void EventIndex::ChangesBetween(float t0, float t1, std::vector<Entry>& changes) const {
+	changes.clear();
+	size_t s = std::upper_bound(entries.begin(), entries.end(), t0, [](float t, const Entry& e) { return t < e.start; }) - entries.begin();
+	for (; s < entries.size() && entries[s].start <= t1; s++)
+		changes.push_back(entries[s]);
+	size_t e = std::upper_bound(byEnd.begin(), byEnd.end(), t0, [this](float t, int i) { return t < entries[i].end; }) - byEnd.begin();
+	for (; e < byEnd.size() && entries[byEnd[e]].end <= t1; e++)
+		changes.push_back(entries[byEnd[e]]);
+}
+
+const std::vector<float>& EventIndex::StartsOf(int body) const {
+	static const std::vector<float> none;
+	return body >= 0 && body < (int)bodyStarts.size() ? bodyStarts[body] : none;
+}
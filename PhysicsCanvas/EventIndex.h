@@ -0,0 +1,43 @@
+#pragma once
+#include "pch.h"
+#include "PhysicsBody.h"
+#include <list>
+#include <vector>
+
+namespace PhysicsCanvas {
+	//Every body's force events by when they act, so the editor can ask which are acting at a time or which start or stop
+	//in a span without going through every event of every body. An event acts from its start until its end, or for good
+	//from its start for a weight. Bodies are numbered by where they are in the list
+	class EventIndex {
+	public:
+		struct Entry {
+			float start;
+			float end;
+			int body;
+			int event;	//index into the body's force events
+		};
+
+		//brings the index up to date with the bodies, only sorting again if a body has come or gone or had its events changed
+		void Sync(std::list<std::shared_ptr<PhysicsBody>>& bodies);
+
+		//the events acting at time, in no particular order
+		void ActiveAt(float time, std::vector<Entry>& active) const;
+
+		//the events that start or stop after t0 up to and including t1, starts first, each in time order
+		void ChangesBetween(float t0, float t1, std::vector<Entry>& changes) const;
+
+		//when the body's force events start, earliest first
+		const std::vector<float>& StartsOf(int body) const;
+	private:
+		//adds the entries from lo to hi (not including hi) that act at time, the middle one being the root of the range's subtree
+		void Stab(size_t lo, size_t hi, float time, std::vector<Entry>& active) const;
+
+		std::vector<Entry> entries;		//by start
+		std::vector<float> maxEnd;		//the latest end in the subtree under each entry, see Stab()
+		std::vector<int> byEnd;			//indices into entries, by end
+		std::vector<std::vector<float>> bodyStarts;
+
+		//what the index was built from
+		std::vector<std::pair<PhysicsBody*, unsigned int>> synced;
+	};
+}
@@ -0,0 +1,101 @@
+#include "EventTimeline.h"
+#include <algorithm>
+#include <climits>
+
+using namespace PhysicsCanvas;
+
+bool EventTimeline::Before(const Change& a, const Change& b) {
+	return a.time < b.time || (a.time == b.time && a.index < b.index);
+}
+
+size_t EventTimeline::After(const std::vector<Change>& changes, float time) {
+	Change now = { time, INT_MAX };
+	return std::upper_bound(changes.begin(), changes.end(), now, Before) - changes.begin();
+}
+
+void EventTimeline::Sync(const std::vector<Force*>& forces, unsigned int revision) {
+	if (built && forces.size() == forceCount && revision == builtRevision)
+		return;
+	built = true;
+	forceCount = forces.size();
+	builtRevision = revision;
+	activeValid = false;
+	starts.clear();
+	ends.clear();
+	acts.clear();
+	for (int i = 0; i < (int)forces.size(); i++) {
+		Force* f = forces[i];
+		starts.push_back({ f->GetStart(), i });
+		ends.push_back({ f->GetEnd(), i });
+		acts.push_back(f->GetForceType() == Force::Weight ? ForGood : UntilEnd);
+	}
+	std::sort(starts.begin(), starts.end(), Before);
+	std::sort(ends.begin(), ends.end(), Before);
+}
+
+const std::vector<int>& EventTimeline::ActiveForces(const std::vector<Force*>& forces, unsigned int revision, float time) {
+	Sync(forces, revision);
+	if (!activeValid) {
+		//everything that has started by time and not stopped yet
+		nextStart = After(starts, time);
+		nextEnd = After(ends, time);
+		active.clear();
+		for (size_t s = 0; s < nextStart; s++)
+			active.push_back(starts[s].index);
+		std::sort(active.begin(), active.end());
+		for (size_t e = 0; e < nextEnd; e++) {
+			if (acts[ends[e].index] == UntilEnd)
+				Deactivate(ends[e].index);
+		}
+		activeValid = true;
+	}
+	else if (time >= activeTime) {
+		//a force that starts and stops in between is added then taken off again, as they're all started before any stop
+		for (; nextStart < starts.size() && starts[nextStart].time <= time; nextStart++)
+			Activate(starts[nextStart].index);
+		for (; nextEnd < ends.size() && ends[nextEnd].time <= time; nextEnd++) {
+			if (acts[ends[nextEnd].index] == UntilEnd)
+				Deactivate(ends[nextEnd].index);
+		}
+	}
+	else {
+		//the same undone in reverse, the stops put back before the starts are taken off
+		for (; nextEnd > 0 && ends[nextEnd - 1].time > time; nextEnd--) {
+			if (acts[ends[nextEnd - 1].index] == UntilEnd)
+				Activate(ends[nextEnd - 1].index);
+		}
+		for (; nextStart > 0 && starts[nextStart - 1].time > time; nextStart--)
+			Deactivate(starts[nextStart - 1].index);
+	}
+	activeTime = time;
+	return active;
+}
+
+bool EventTimeline::ChangesBetween(const std::vector<Force*>& forces, unsigned int revision, float t0, float t1) {
+	Sync(forces, revision);
+	size_t s = After(starts, t0);
+	size_t e = After(ends, t0);
+	return (s < starts.size() && starts[s].time <= t1) || (e < ends.size() && ends[e].time <= t1);
+}
+
+void EventTimeline::ChangesBetween(const std::vector<Force*>& forces, unsigned int revision, float t0, float t1,
+	std::vector<int>& indices) {
+	Sync(forces, revision);
+	indices.clear();
+	for (size_t s = After(starts, t0); s < starts.size() && starts[s].time <= t1; s++)
+		indices.push_back(starts[s].index);
+	for (size_t e = After(ends, t0); e < ends.size() && ends[e].time <= t1; e++)
+		indices.push_back(ends[e].index);
+}
+
+void EventTimeline::Activate(int index) {
+	std::vector<int>::iterator it = std::lower_bound(active.begin(), active.end(), index);
+	if (it == active.end() || *it != index)
+		active.insert(it, index);
+}
+
+void EventTimeline::Deactivate(int index) {
+	std::vector<int>::iterator it = std::lower_bound(active.begin(), active.end(), index);
+	if (it != active.end() && *it == index)
+		active.erase(it);
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include "pch.h"
+#include "Force.h"
+#include <vector>
+
+namespace PhysicsCanvas {
+	//A body's force events sorted by when they start and when they stop. Asking for what's acting at a different time from
+	//last time only looks at the forces that start or stop in between, forwards or backwards, rather than checking every
+	//force's times again, and what starts or stops between two times is found with a binary search.
+	//revision is the body's count of changes to its events' times, the forces are only sorted again when it changes
+	class EventTimeline {
+	public:
+		//the indices into forces of the ones acting at time, in the same order as they are in forces. Whether they are
+		//toggled on isn't looked at, as that changes from step to step for collision forces
+		const std::vector<int>& ActiveForces(const std::vector<Force*>& forces, unsigned int revision, float time);
+
+		//whether any force starts or stops after t0, up to and including t1
+		bool ChangesBetween(const std::vector<Force*>& forces, unsigned int revision, float t0, float t1);
+
+		//the indices of the forces that start after t0 up to t1, then of those that stop then, each in time order.
+		//A force that does both is in there twice
+		void ChangesBetween(const std::vector<Force*>& forces, unsigned int revision, float t0, float t1,
+			std::vector<int>& indices);
+	private:
+		struct Change {
+			float time;
+			int index;
+		};
+
+		enum Acts : uint8_t {
+			UntilEnd,
+			ForGood		//a weight, it keeps acting once it's started whatever its end is
+		};
+
+		//by time, then by index so that changes at the same time always come in the same order
+		static bool Before(const Change& a, const Change& b);
+
+		//the first change after time
+		static size_t After(const std::vector<Change>& changes, float time);
+
+		void Sync(const std::vector<Force*>& forces, unsigned int revision);
+
+		void Activate(int index);
+		void Deactivate(int index);
+
+		std::vector<Change> starts;	//oldest first
+		std::vector<Change> ends;
+		std::vector<Acts> acts;		//for each force
+
+		std::vector<int> active;	//in index order
+		bool activeValid = false;
+		float activeTime = 0;
+		size_t nextStart = 0;	//the first in starts that hasn't started by activeTime
+		size_t nextEnd = 0;
+
+		//what the sort was done from, to tell when it needs doing again
+		bool built = false;
+		size_t forceCount = 0;
+		unsigned int builtRevision = 0;
+	};
+}
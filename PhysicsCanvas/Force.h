@@ -1,15 +1,16 @@
 #pragma once
 
-#include "..\Common\DirectXHelper.h"
 #include <DirectXMath.h>
 #include <list>
+#include "BodyStore.h"
 #include "PEvent.h"
 #include <sstream>
+#include <vector>
 
 namespace PhysicsCanvas {
 	class Force : public PEvent {
 	public:
-		static enum ForceType {
+		enum ForceType {
 			Impulse,
 			Constant,
 			Weight,
@@ -30,6 +31,9 @@ namespace PhysicsCanvas {
 			SetId("Weight");
 		}
 
+		//declared as there's an assignment of its own below, a copy is made the same way as it would be otherwise
+		Force(const Force&) = default;
+
 		void SetStart(float start) {
 			PEvent::SetStart(start);
 			if (type == ForceType::Impulse) {
@@ -52,6 +56,7 @@ namespace PhysicsCanvas {
 		ForceType GetForceType() { return type; }
 		void SetForceType(ForceType newType) { 
 			type = newType;
+			TimingChanged();	//a weight acts from its start for good, the others stop at their end
 			if (newType == ForceType::Impulse) {
 				SetEnd(GetStart() + 0.003f);
 			}
@@ -65,6 +70,16 @@ namespace PhysicsCanvas {
 		DirectX::XMFLOAT3 GetFrom() { return fromPoint; }
 		void SetFrom(DirectX::XMFLOAT3 Point) { fromPoint = Point; }
 
+		//for the forces a collision makes, the body it's with and which of the contacts with it a reaction is at (-1 for the
+		//impulse), so the body finds them again by these rather than by their IDs
+		void SetCollider(BodyHandle body, int contact) {
+			fromCollision = true;
+			collider = body;
+			colliderContact = contact;
+		}
+		bool IsFrom(BodyHandle body) { return fromCollision && collider == body; }
+		bool IsFrom(BodyHandle body, int contact) { return IsFrom(body) && colliderContact == contact; }
+
 		std::string EData() {
 			if (type == Weight)
 				return "";
@@ -81,12 +96,12 @@ namespace PhysicsCanvas {
 			return data.str();
 		}
 
-		static Force ResultantF(std::list<Force> forces) {
+		static Force ResultantF(const std::vector<Force*>& forces) {
 			Force result(ForceType::Constant, DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f));
-			for (Force f : forces) {
-				result.direction.x += f.direction.x;
-				result.direction.y += f.direction.y;
-				result.direction.z += f.direction.z;
+			for (const Force* f : forces) {
+				result.direction.x += f->direction.x;
+				result.direction.y += f->direction.y;
+				result.direction.z += f->direction.z;
 			}
 			return result;
 		}
@@ -99,6 +114,10 @@ namespace PhysicsCanvas {
 			direction = f1.GetDirection();
 			fromPoint = f1.GetFrom();
 			SetToggle(f1.GetToggle());
+			SetNumber(f1.GetNumber());
+			fromCollision = f1.fromCollision;
+			collider = f1.collider;
+			colliderContact = f1.colliderContact;
 		}
 
 		bool operator == (Force f1) {
@@ -132,6 +151,9 @@ namespace PhysicsCanvas {
 		ForceType type;
 		DirectX::XMFLOAT3 direction;
 		DirectX::XMFLOAT3 fromPoint;
+		bool fromCollision = false;
+		BodyHandle collider = 0;
+		int colliderContact = -1;
 		DirectX::XMFLOAT3 colour;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,600 @@
+//Benchmarks for the physics and the recorded history, kept apart from the runner so that running a scene only times the scene.
+//Usage: HeadlessBench <scene.psim> <end time in seconds> [-threads n] [-broadphase tree|sap|hash] [-error e] [-tolerance t]
+//                     [-integrator scalar|sse|avx2|avx512]
+//Steps the scene the same way the runner does, counting the heap allocations the steps make, and checks stepping it on one
+//thread and on n (4 if not given) records exactly the same history, exiting with 1 if not. Then times retrieving records
+//from the last body's history, scanning a value over it a record at a time and as a column, and the history analytics.
+//After that, how many body-steps a second each of the batch integrator's kernels manages, what a step costs for bodies
+//with 1, 10 and 100 events, how a step's cost comes down from 1 worker up to one per hardware thread, how the broadphases'
+//cost grows with the number of bodies and what the narrowphase saves by the shapes keeping their geometry. Last, the world's event index is checked against going through every event, and the
+//numbers a body gives its forces are checked to stay distinct, exiting with 1 if either fails. Everything is printed to stderr
+#include "HeadlessScene.h"
+#include "../HistoryAnalytics.h"
+#include "../PhysicsWorld.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <new>
+#include <thread>
+
+using namespace PhysicsCanvas;
+
+//every heap allocation the program makes goes through here, so the steps can be checked for any they don't need
+static std::atomic<size_t> allocations(0);
+
+void* operator new(size_t size) {
+	allocations++;
+	void* p = malloc(size ? size : 1);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+//Steps the scene from the start on one thread and then on threads, set up the same way, and checks every record each body
+//has recorded is the same to the bit both times. The worker pool only splits the bodies between threads, it shouldn't
+//change what any of them works out. False if any record differs
+static bool CheckThreads(const char* scenePath, float endTime, unsigned int threads, float errorBound, float tolerance) {
+	std::list<std::shared_ptr<PhysicsBody>> runs[2];
+	unsigned int threadCounts[] = { 1, threads };
+	for (int r = 0; r < 2; r++) {
+		HeadlessScene::Load(scenePath, runs[r]);
+		for (std::shared_ptr<PhysicsBody> b : runs[r]) {
+			b->GetTimeKeeper().SetErrorBound(errorBound);
+			b->GetTimeKeeper().SetRecordingTolerance(tolerance);
+			b->GetTimeKeeper().Wipe({ 0, b->GetPosition(), b->GetRotation(), b->GetVelocity(), b->GetAngularVelocity() });
+		}
+		PhysicsWorld world;
+		world.SetThreadCount(threadCounts[r]);
+		float time = 0;
+		while (time < endTime)
+			time = world.Step(runs[r], time);
+	}
+
+	size_t compared = 0, differences = 0;
+	std::list<std::shared_ptr<PhysicsBody>>::iterator other = runs[1].begin();
+	for (std::shared_ptr<PhysicsBody>& body : runs[0]) {
+		TimeKeeper& single = body->GetTimeKeeper();
+		TimeKeeper& multi = (*other)->GetTimeKeeper();
+		size_t count = single.GetCount() < multi.GetCount() ? single.GetCount() : multi.GetCount();
+		//a body that recorded a different number of steps differs in all of the ones the other hasn't got
+		differences += single.GetCount() - count + multi.GetCount() - count;
+		for (size_t i = 0; i < count; i++) {
+			Record a = single.At(i);
+			Record b = multi.At(i);
+			differences += memcmp(&a, &b, sizeof(Record)) != 0 ? 1 : 0;
+			compared++;
+		}
+		other++;
+	}
+	fprintf(stderr, "1 and %u threads: %zu of %zu records differ\n", threads, differences, compared);
+	return differences == 0;
+}
+
+//Asks the world's event index which events act at random times and which start or stop between random pairs of times, for
+//200 bodies with 50 events each, and checks it finds exactly what going through every event of every body finds. Both are
+//timed. False if they ever disagree
+static bool CheckEventIndex() {
+	const int bodyCount = 200;
+	const int eventCount = 50;
+	const int queries = 2000;
+	std::list<std::shared_ptr<PhysicsBody>> bodies;
+	unsigned int seed = 4321;
+	for (int b = 0; b < bodyCount; b++) {
+		std::shared_ptr<PhysicsBody> body = std::make_shared<PhysicsBody>();
+		body->Create(CUBE, nullptr);
+		for (int e = 1; e < eventCount; e++) {
+			std::shared_ptr<Force> push = std::make_shared<Force>(e % 10 == 0 ? Force::Impulse : Force::Constant, XMFLOAT3(0, 1, 0));
+			seed = seed * 1103515245 + 12345;
+			push->SetStart(((seed >> 8) % 1000) / 100.0f);
+			seed = seed * 1103515245 + 12345;
+			push->SetEnd(push->GetStart() + ((seed >> 8) % 300) / 100.0f);
+			body->AddEvent(push);
+		}
+		bodies.push_back(body);
+	}
+	PhysicsWorld world;
+	const EventIndex& index = world.Events(bodies);
+
+	//what the index should find, straight from the events
+	auto scan = [&](float t0, float t1, bool changes, std::vector<std::pair<int, int>>& found) {
+		found.clear();
+		int b = 0;
+		for (std::shared_ptr<PhysicsBody>& body : bodies) {
+			const std::vector<Force*>& forces = body->GetForceEvents();
+			for (int e = 0; e < (int)forces.size(); e++) {
+				float start = forces[e]->GetStart();
+				float end = forces[e]->GetForceType() == Force::Weight ? std::numeric_limits<float>::infinity() : forces[e]->GetEnd();
+				if (!changes && start <= t1 && end > t1)
+					found.push_back({ b, e });
+				if (changes && start > t0 && start <= t1)
+					found.push_back({ b, e });
+				if (changes && end > t0 && end <= t1)
+					found.push_back({ b, e });
+			}
+			b++;
+		}
+		std::sort(found.begin(), found.end());
+	};
+
+	double indexNs = 0, scanNs = 0;
+	size_t mismatches = 0, total = 0;
+	std::vector<EventIndex::Entry> entries;
+	std::vector<std::pair<int, int>> fromIndex, fromScan;
+	for (int q = 0; q < queries; q++) {
+		seed = seed * 1103515245 + 12345;
+		float t0 = ((seed >> 8) % 1300) / 100.0f;
+		seed = seed * 1103515245 + 12345;
+		float t1 = t0 + ((seed >> 8) % 100) / 100.0f;
+		bool changes = q % 2 == 1;
+		auto queryStart = std::chrono::steady_clock::now();
+		if (changes)
+			index.ChangesBetween(t0, t1, entries);
+		else
+			index.ActiveAt(t1, entries);
+		indexNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - queryStart).count();
+		queryStart = std::chrono::steady_clock::now();
+		scan(t0, t1, changes, fromScan);
+		scanNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - queryStart).count();
+
+		fromIndex.clear();
+		for (const EventIndex::Entry& entry : entries)
+			fromIndex.push_back({ entry.body, entry.event });
+		std::sort(fromIndex.begin(), fromIndex.end());
+		mismatches += fromIndex != fromScan ? 1 : 0;
+		total += fromScan.size();
+	}
+	fprintf(stderr, "event index: %.0fns a query, %.0fns going through every event, %zu of %d queries differ (%zu events found)\n",
+		indexNs / queries, scanNs / queries, mismatches, queries, total);
+	return mismatches == 0;
+}
+
+//Adds two forces to a cube sitting on the floor and steps it until the floor pushes back, then checks every event and force
+//on the cube has a number of its own. The numbers are checked again after the forces are copied into a vector one at a
+//time, so it has to grow and move them, and after the cube is put back to a checkpoint, as both copy the forces. False if
+//any number is missing or shared
+static bool CheckEventNumbers() {
+	std::list<std::shared_ptr<PhysicsBody>> bodies;
+	std::shared_ptr<PhysicsBody> floor = std::make_shared<PhysicsBody>();
+	floor->Create(FLOOR, nullptr);
+	floor->GiveName("floor");
+	std::shared_ptr<PhysicsBody> cube = std::make_shared<PhysicsBody>();
+	cube->Create(CUBE, nullptr);
+	cube->GiveName("cube");
+	cube->SetTransform(XMFLOAT3(0, 0.45f, 0), XMFLOAT3(), cube->GetDimensions());
+	cube->AddForce(Force::Constant, XMFLOAT3(0.1f, 0, 0), 0);
+	cube->AddForce(Force::Constant, XMFLOAT3(0, 0, 0.1f), 0);
+	for (std::shared_ptr<PhysicsBody> b : { floor, cube }) {
+		b->GetTimeKeeper().Wipe({ 0, b->GetPosition(), b->GetRotation(), b->GetVelocity(), b->GetAngularVelocity() });
+		bodies.push_back(b);
+	}
+	PhysicsWorld world;
+	float time = 0;
+	int reactions = 0;
+	while (reactions == 0 && time < 1) {
+		time = world.Step(bodies, time);
+		for (Force& f : cube->GetForces())
+			reactions += f.GetForceType() == Force::Reaction ? 1 : 0;
+	}
+
+	auto distinct = [&](const std::vector<int>& numbers) {
+		std::vector<int> sorted = numbers;
+		std::sort(sorted.begin(), sorted.end());
+		return !sorted.empty() && sorted.front() >= 0 && std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end();
+	};
+	std::vector<int> numbers;
+	for (Force* f : cube->GetForceEvents())
+		numbers.push_back(f->GetNumber());
+	for (Force& f : cube->GetForces())
+		numbers.push_back(f.GetNumber());
+	bool onBody = distinct(numbers);
+
+	std::vector<Force> grown;
+	for (Force& f : cube->GetForces())
+		grown.push_back(f);
+	numbers.clear();
+	for (Force& f : grown)
+		numbers.push_back(f.GetNumber());
+	bool afterGrowing = distinct(numbers) && grown.size() == cube->GetForces().size();
+
+	BodyState state = cube->SaveState(time);
+	cube->AddForce(Force::Constant, XMFLOAT3(0, 0.1f, 0), time);
+	cube->RestoreState(state);
+	numbers.clear();
+	for (Force& f : cube->GetForces())
+		numbers.push_back(f.GetNumber());
+	bool afterRestoring = distinct(numbers);
+
+	fprintf(stderr, "event numbers: %zu forces (%d reactions), distinct on the body %s, after growing %s, after restoring %s\n",
+		cube->GetForces().size(), reactions, onBody ? "yes" : "no", afterGrowing ? "yes" : "no", afterRestoring ? "yes" : "no");
+	return onBody && afterGrowing && afterRestoring;
+}
+
+//Retrieving records at random times, like scrubbing the timeline, then in order, like replaying it. Then scanning one
+//value over the whole history, like plotting it, and the analytics on one thread and on threads
+static void BenchmarkHistory(std::list<std::shared_ptr<PhysicsBody>>& bodies, unsigned int threads) {
+	const int lookups = 100000;
+	unsigned int seed = 12345;
+	TimeKeeper& keeper = bodies.back()->GetTimeKeeper();
+	size_t samples = keeper.GetCount();
+	float checksum = 0;
+	auto lookupStart = std::chrono::steady_clock::now();
+	for (int i = 0; i < lookups; i++) {
+		seed = seed * 1103515245 + 12345;
+		checksum += keeper.Retrieve(keeper.TimeOf((seed >> 8) % samples)).position.y;
+	}
+	double randomNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - lookupStart).count() / lookups;
+	lookupStart = std::chrono::steady_clock::now();
+	for (int i = 0; i < lookups; i++)
+		checksum += keeper.Retrieve(keeper.TimeOf(i % samples)).position.y;
+	double sequentialNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - lookupStart).count() / lookups;
+	fprintf(stderr, "retrieve: %.1fns random, %.1fns in order (%g)\n", randomNs, sequentialNs, checksum);
+
+	//a record at a time and then as a column
+	float recordSum = 0, columnSum = 0;
+	auto scanStart = std::chrono::steady_clock::now();
+	for (const Record& r : keeper.GetRecords())
+		recordSum += r.position.y;
+	double recordNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - scanStart).count() / samples;
+	std::vector<float> column;
+	scanStart = std::chrono::steady_clock::now();
+	for (float y : keeper.ReadColumn(TimeKeeper::PositionY, 0, samples, column))
+		columnSum += y;
+	double columnNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - scanStart).count() / samples;
+	fprintf(stderr, "scan %zu samples: %.2fns per record, %.2fns per column value (%g %g)\n",
+		samples, recordNs, columnNs, recordSum, columnSum);
+
+	//peak speed a record at a time, then with the analytics
+	scanStart = std::chrono::steady_clock::now();
+	float peak = 0;
+	for (size_t i = 0; i < samples; i++) {
+		float speed = PhysMaths::Magnitude(keeper.Retrieve(keeper.TimeOf(i)).velocity);
+		peak = speed > peak ? speed : peak;
+	}
+	double retrieveMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - scanStart).count();
+	fprintf(stderr, "peak speed by retrieving every step: %g in %.2fms\n", peak, retrieveMs);
+	unsigned int analyticsThreads[] = { 1, threads };
+	for (unsigned int n : analyticsThreads) {
+		HistoryAnalytics analytics(n);
+		scanStart = std::chrono::steady_clock::now();
+		HistoryAnalytics::Summary speed = analytics.Summarise(*bodies.back(), HistoryAnalytics::Speed);
+		double summaryMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - scanStart).count();
+		scanStart = std::chrono::steady_clock::now();
+		float drift = analytics.EnergyDrift(bodies);
+		double driftMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - scanStart).count();
+		fprintf(stderr, "analytics on %u threads: speed max %g at %gs, mean %g, distance %g in %.2fms; energy drift %g in %.2fms\n",
+			analytics.GetThreadCount(), speed.max, speed.maxTime, speed.mean, speed.integral, summaryMs, drift, driftMs);
+	}
+}
+
+//Each broadphase and checking every pair against each other, for 10, 50, 100, 1000 and 10000 bodies spread out so that each has
+//about as many neighbours whatever the count. The bodies are moved a little between frames, like a step moves them, and
+//their boxes worked out before the broadphase is timed, so only finding the pairs is timed
+static void BenchmarkBroadphase() {
+	const int bodyCounts[] = { 10, 50, 100, 1000, 10000 };
+	const int frames = 5;
+	const Broadphase::Type types[] = { Broadphase::SweepPrune, Broadphase::SpatialHash, Broadphase::DynamicTree };
+	const char* names[] = { "sweep and prune", "spatial hash", "tree" };
+	for (int count : bodyCounts) {
+		std::list<std::shared_ptr<PhysicsBody>> bodies;
+		float side = 3.0f * cbrt((float)count);
+		unsigned int seed = 777;
+		for (int b = 0; b < count; b++) {
+			std::shared_ptr<PhysicsBody> body = std::make_shared<PhysicsBody>();
+			body->Create(CUBE, nullptr);
+			XMFLOAT3 position;
+			seed = seed * 1103515245 + 12345;
+			position.x = ((seed >> 8) % 10000) / 10000.0f * side;
+			seed = seed * 1103515245 + 12345;
+			position.y = ((seed >> 8) % 10000) / 10000.0f * side;
+			seed = seed * 1103515245 + 12345;
+			position.z = ((seed >> 8) % 10000) / 10000.0f * side;
+			body->SetTransform(position, XMFLOAT3(), body->GetDimensions());
+			bodies.push_back(body);
+		}
+
+		double ns[4] = { 0, 0, 0, 0 };
+		size_t pairs[4] = { 0, 0, 0, 0 };
+		std::unique_ptr<Broadphase> broadphases[3];
+		for (int t = 0; t < 3; t++)
+			broadphases[t] = Broadphase::Create(types[t]);
+		for (int f = 0; f < frames; f++) {
+			for (std::shared_ptr<PhysicsBody>& body : bodies) {
+				XMFLOAT3 position = body->GetPosition();
+				position.y += f % 2 == 0 ? 0.05f : -0.05f;
+				body->SetTransform(position, body->GetRotation(), body->GetDimensions());
+				body->RefreshBounds();
+			}
+			for (int t = 0; t < 3; t++) {
+				auto benchStart = std::chrono::steady_clock::now();
+				broadphases[t]->Update(bodies);
+				ns[t] += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - benchStart).count();
+				pairs[t] = broadphases[t]->CandidatePairs().size();
+			}
+
+			//every pair, like the step did before it had a broadphase. None of the bodies have been in a world, so they're all
+			//still in the store they were made in
+			BodyStore& store = bodies.front()->GetStore();
+			std::vector<BodyHandle> handles;
+			for (std::shared_ptr<PhysicsBody>& body : bodies)
+				handles.push_back(body->GetHandle());
+			auto benchStart = std::chrono::steady_clock::now();
+			size_t found = 0;
+			for (size_t i = 0; i < handles.size(); i++) {
+				XMFLOAT3 minA = store.Get3(BodyStore::MinX, handles[i]), maxA = store.Get3(BodyStore::MaxX, handles[i]);
+				for (size_t j = i + 1; j < handles.size(); j++) {
+					XMFLOAT3 minB = store.Get3(BodyStore::MinX, handles[j]), maxB = store.Get3(BodyStore::MaxX, handles[j]);
+					if (minA.x <= maxB.x && maxA.x >= minB.x && minA.y <= maxB.y && maxA.y >= minB.y && minA.z <= maxB.z && maxA.z >= minB.z)
+						found++;
+				}
+			}
+			ns[3] += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - benchStart).count();
+			pairs[3] = found;
+		}
+		for (int t = 0; t < 3; t++)
+			fprintf(stderr, "broadphase %s, %d bodies: %.0fns per body a frame, %zu pairs\n", names[t], count, ns[t] / ((double)frames * count), pairs[t]);
+		fprintf(stderr, "broadphase every pair, %d bodies: %.0fns per body a frame, %zu pairs\n", count, ns[3] / ((double)frames * count), pairs[3]);
+	}
+}
+
+//The narrowphase between pairs of overlapping, rotated boxes, first with their cached geometry and then marking every shape
+//as moved before each test, so the vertices, faces and normals have to be worked out again each time like they were before
+//the shapes kept them
+static void BenchmarkGeometry() {
+	const int pairCount = 1000;
+	const int passes = 50;
+	std::vector<BoundingShape> shapes;
+	unsigned int seed = 999;
+	for (int i = 0; i < pairCount * 2; i++) {
+		seed = seed * 1103515245 + 12345;
+		float angle = ((seed >> 8) % 628) / 100.0f;
+		XMFLOAT3 position((i / 2) * 10.0f + (i % 2) * 0.8f, (i % 2) * 0.3f, 0);
+		shapes.push_back(BoundingShape(BoundingShape::Cuboid, position, XMFLOAT3(angle, angle * 0.5f, 0), XMFLOAT3(1, 1, 1)));
+	}
+	for (int recompute = 0; recompute < 2; recompute++) {
+		ContactManifold manifold;
+		int colliding = 0;
+		auto benchStart = std::chrono::steady_clock::now();
+		for (int p = 0; p < passes; p++) {
+			for (int i = 0; i < pairCount; i++) {
+				BoundingShape& first = shapes[i * 2];
+				BoundingShape& other = shapes[i * 2 + 1];
+				if (recompute) {
+					first.SetDimensions(XMFLOAT3(1, 1, 1));
+					other.SetDimensions(XMFLOAT3(1, 1, 1));
+				}
+				colliding += BoundingShape::CuboidsColliding(first, other, &manifold) ? 1 : 0;
+			}
+		}
+		double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - benchStart).count();
+		fprintf(stderr, "narrowphase %s: %.0fns per pair, %d of %d colliding\n", recompute ? "recomputing geometry" : "cached geometry",
+			ns / ((double)passes * pairCount), colliding / passes, pairCount);
+	}
+}
+
+//Every kernel the CPU can run over arrays of count bodies, the 3 linear and 3 angular values of each like a step does, with
+//1 in 8 bodies replaying rather than integrating. Each is checked against the scalar kernel, which they should match exactly.
+//Which kernel the steps are dispatched to is printed first, so a build that can't use the wider ones shows up
+static void BenchmarkIntegrator(size_t count) {
+	fprintf(stderr, "integrator dispatched to %s, the widest this build and CPU can run is %s\n",
+		BatchIntegrator::Name(BatchIntegrator::GetKernel()), BatchIntegrator::Name(BatchIntegrator::Best()));
+	typedef std::vector<float, AlignedAllocator<float, BodyStore::ALIGNMENT>> Column;
+	const int values = 6;
+	const int passes = 2000;
+	Column accel[values], vel[values], out[values], start[values], expectedVel[values], expectedOut[values];
+	std::vector<uint8_t> flags(count);
+	unsigned int seed = 54321;
+	for (int v = 0; v < values; v++) {
+		accel[v].resize(count);
+		start[v].resize(count);
+		out[v].resize(count);
+		for (size_t i = 0; i < count; i++) {
+			seed = seed * 1103515245 + 12345;
+			accel[v][i] = ((seed >> 8) % 2001) / 100.0f - 10.0f;
+			seed = seed * 1103515245 + 12345;
+			start[v][i] = ((seed >> 8) % 2001) / 100.0f - 10.0f;
+		}
+	}
+	for (size_t i = 0; i < count; i++)
+		flags[i] = i % 8 == 7 ? BodyStore::InUse : BodyStore::InUse | BodyStore::Integrating;
+
+	for (int k = BatchIntegrator::Scalar; k < BatchIntegrator::KERNEL_COUNT; k++) {
+		BatchIntegrator::Kernel kernel = (BatchIntegrator::Kernel)k;
+		if (!BatchIntegrator::Supported(kernel))
+			continue;
+		for (int v = 0; v < values; v++) {
+			vel[v] = start[v];
+			std::fill(out[v].begin(), out[v].end(), 0.0f);
+		}
+		auto benchStart = std::chrono::steady_clock::now();
+		for (int p = 0; p < passes; p++) {
+			for (int v = 0; v < values; v++)
+				BatchIntegrator::Advance(kernel, accel[v].data(), vel[v].data(), out[v].data(), flags.data(), BodyStore::Integrating, 0, count, 0.001f);
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - benchStart).count();
+		float difference = 0;
+		for (int v = 0; v < values; v++) {
+			if (kernel == BatchIntegrator::Scalar) {
+				expectedVel[v] = vel[v];
+				expectedOut[v] = out[v];
+			}
+			for (size_t i = 0; i < count; i++) {
+				float d = abs(vel[v][i] - expectedVel[v][i]) + abs(out[v][i] - expectedOut[v][i]);
+				difference = d > difference ? d : difference;
+			}
+		}
+		fprintf(stderr, "integrator %s (%d wide): %.3g body-steps/s, largest difference from scalar %g\n",
+			BatchIntegrator::Name(kernel), BatchIntegrator::Width(kernel), seconds > 0 ? passes * count / seconds : 0.0, difference);
+	}
+}
+
+//Steps the same scene, 1000 cubes falling in a grid onto the floor so the later steps have collisions to handle, on 1, 2, 4
+//and so on up to the number of hardware threads, to show how the step's cost comes down as workers are added
+static void BenchmarkThreads() {
+	const int side = 10;
+	const int steps = 300;
+	unsigned int hardware = std::thread::hardware_concurrency();
+	if (hardware == 0)
+		hardware = 1;
+	std::vector<unsigned int> threadCounts;
+	for (unsigned int t = 1; t < hardware; t *= 2)
+		threadCounts.push_back(t);
+	threadCounts.push_back(hardware);
+
+	double singleMs = 0;
+	for (unsigned int threads : threadCounts) {
+		std::list<std::shared_ptr<PhysicsBody>> bodies;
+		std::shared_ptr<PhysicsBody> floor = std::make_shared<PhysicsBody>();
+		floor->Create(FLOOR, nullptr);
+		bodies.push_back(floor);
+		for (int b = 0; b < side * side * side; b++) {
+			std::shared_ptr<PhysicsBody> body = std::make_shared<PhysicsBody>();
+			body->Create(CUBE, nullptr);
+			body->GiveName("bench" + std::to_string(b));
+			XMFLOAT3 position(3.0f * (b % side), 0.6f + 3.0f * (b / (side * side)), 3.0f * ((b / side) % side));
+			body->SetTransform(position, XMFLOAT3(), body->GetDimensions());
+			bodies.push_back(body);
+		}
+		for (std::shared_ptr<PhysicsBody>& b : bodies)
+			b->GetTimeKeeper().Wipe({ 0, b->GetPosition(), b->GetRotation(), b->GetVelocity(), b->GetAngularVelocity() });
+		PhysicsWorld world;
+		world.SetThreadCount(threads);
+		float time = 0;
+		auto benchStart = std::chrono::steady_clock::now();
+		for (int s = 0; s < steps; s++)
+			time = world.Step(bodies, time);
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - benchStart).count() / steps;
+		if (threads == 1)
+			singleMs = ms;
+		fprintf(stderr, "%u worker%s, %zu bodies: %.3fms per step, %.2fx the speed of 1\n", threads, threads == 1 ? "" : "s", bodies.size(), ms, ms > 0 ? singleMs / ms : 0.0);
+	}
+}
+
+//Steps bodies with 1, 10 and 100 events each (their weight and the rest small pushes that start and stop through the run),
+//far enough apart not to collide, to show how much a body's events add to what a step costs
+static void BenchmarkEvents(unsigned int threads) {
+	const int bodyCount = 200;
+	const int steps = 500;
+	const int eventCounts[] = { 1, 10, 100 };
+	for (int events : eventCounts) {
+		std::list<std::shared_ptr<PhysicsBody>> bodies;
+		for (int b = 0; b < bodyCount; b++) {
+			std::shared_ptr<PhysicsBody> body = std::make_shared<PhysicsBody>();
+			body->Create(CUBE, nullptr);
+			body->GiveName("bench" + std::to_string(b));
+			body->SetTransform(XMFLOAT3(b * 10.0f, 100.0f, 0), XMFLOAT3(), body->GetDimensions());
+			for (int e = 1; e < events; e++) {
+				std::shared_ptr<Force> push = std::make_shared<Force>(Force::Constant, XMFLOAT3(0.01f * (e % 3), 0.01f, 0));
+				push->SetStart((e % 40) * 0.01f);
+				push->SetEnd(push->GetStart() + 0.05f + (e % 7) * 0.01f);
+				push->SetFrom(body->GetPosition());
+				body->AddEvent(push);
+			}
+			body->GetTimeKeeper().Wipe({ 0, body->GetPosition(), body->GetRotation(), body->GetVelocity(), body->GetAngularVelocity() });
+			bodies.push_back(body);
+		}
+		PhysicsWorld world;
+		world.SetThreadCount(threads);
+		float time = 0;
+		auto benchStart = std::chrono::steady_clock::now();
+		for (int s = 0; s < steps; s++)
+			time = world.Step(bodies, time);
+		double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - benchStart).count();
+		fprintf(stderr, "%d events per body: %.0fns per body-step\n", events, ns / ((double)steps * bodyCount));
+	}
+}
+
+int main(int argc, char* argv[]) {
+	if (argc < 3) {
+		std::cerr << "usage: " << argv[0] << " <scene.psim> <end time in seconds> [-threads n] [-broadphase tree|sap|hash] [-error e] [-tolerance t] [-integrator scalar|sse|avx2|avx512]\n";
+		return 1;
+	}
+	const char* scenePath = argv[1];
+	float endTime = (float)atof(argv[2]);
+	unsigned int threads = 0;
+	Broadphase::Type broadphase = Broadphase::DynamicTree;
+	float errorBound = TimeKeeper::DEFAULT_ERROR_BOUND;
+	float tolerance = 0;
+	for (int i = 3; i < argc; i++) {
+		if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc) {
+			threads = (unsigned int)atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-broadphase") == 0 && i + 1 < argc) {
+			i++;
+			if (strcmp(argv[i], "sap") == 0)
+				broadphase = Broadphase::SweepPrune;
+			else if (strcmp(argv[i], "hash") == 0)
+				broadphase = Broadphase::SpatialHash;
+		}
+		else if (strcmp(argv[i], "-error") == 0 && i + 1 < argc) {
+			errorBound = (float)atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-tolerance") == 0 && i + 1 < argc) {
+			tolerance = (float)atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-integrator") == 0 && i + 1 < argc) {
+			i++;
+			for (int k = BatchIntegrator::Scalar; k < BatchIntegrator::KERNEL_COUNT; k++) {
+				if (strcmp(argv[i], BatchIntegrator::Name((BatchIntegrator::Kernel)k)) == 0)
+					BatchIntegrator::SetKernel((BatchIntegrator::Kernel)k);
+			}
+		}
+	}
+
+	std::list<std::shared_ptr<PhysicsBody>> bodies;
+	if (!HeadlessScene::Load(scenePath, bodies)) {
+		std::cerr << "could not open " << scenePath << "\n";
+		return 1;
+	}
+	for (std::shared_ptr<PhysicsBody> b : bodies) {
+		b->GetTimeKeeper().SetErrorBound(errorBound);
+		b->GetTimeKeeper().SetRecordingTolerance(tolerance);
+		b->GetTimeKeeper().Wipe({ 0, b->GetPosition(), b->GetRotation(), b->GetVelocity(), b->GetAngularVelocity() });
+	}
+
+	PhysicsWorld world;
+	world.SetBroadphase(broadphase);
+	if (threads != 0)
+		world.SetThreadCount(threads);
+
+	float time = 0;
+	int steps = 0;
+	//steps that record a block of history or take a checkpoint have to allocate room for it, the rest shouldn't allocate at all
+	size_t stepAllocations = 0;
+	int allocatingSteps = 0;
+	auto start = std::chrono::steady_clock::now();
+	while (time < endTime) {
+		size_t before = allocations;
+		time = world.Step(bodies, time);
+		steps++;
+		stepAllocations += allocations - before;
+		allocatingSteps += allocations != before ? 1 : 0;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	fprintf(stderr, "%d steps (%zu bodies, %u threads, %s integrator) in %.3fs, %.0f steps/s\n",
+		steps, bodies.size(), world.GetThreadCount(), BatchIntegrator::Name(BatchIntegrator::GetKernel()),
+		seconds, seconds > 0 ? steps / seconds : 0.0);
+	fprintf(stderr, "heap allocations: %zu, %.2f per step, %d of %d steps allocated\n",
+		stepAllocations, steps > 0 ? stepAllocations / (double)steps : 0.0, allocatingSteps, steps);
+
+	//with no thread count given, the comparison is still made against more than one
+	bool sameOnThreads = CheckThreads(scenePath, endTime, threads != 0 ? threads : 4, errorBound, tolerance);
+
+	BenchmarkHistory(bodies, world.GetThreadCount());
+	//at least 10000 bodies, so the arrays are too big for the L1 cache like a big scene's are
+	BenchmarkIntegrator(bodies.size() > 10000 ? bodies.size() : 10000);
+	BenchmarkEvents(world.GetThreadCount());
+	BenchmarkThreads();
+	BenchmarkBroadphase();
+	BenchmarkGeometry();
+	bool indexMatches = CheckEventIndex();
+	bool numbersDistinct = CheckEventNumbers();
+	return sameOnThreads && indexMatches && numbersDistinct ? 0 : 1;
+}
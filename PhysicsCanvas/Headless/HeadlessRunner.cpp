@@ -0,0 +1,140 @@
+//Runs a .psim scene without a window or renderer, as fast as the physics allows, and writes out every body's trajectory.
+//Usage: HeadlessRunner <scene.psim> <end time in seconds> [trajectories.csv] [-threads n] [-broadphase tree|sap|hash] [-error e]
+//                      [-history file] [-tolerance t] [-integrator scalar|sse|avx2|avx512]
+//With no output file the trajectories go to stdout. The number of steps and how long they took are printed to stderr,
+//along with how much memory the recorded history takes. The benchmarks are in HeadlessBench.
+//-error sets how far recorded values may be from the simulated ones, 0 records them exactly. -history keeps the recorded
+//history in a memory mapped file rather than in memory. -tolerance only keeps the steps that can't be worked out to within t
+//from the ones kept before them. -integrator picks the batch integrator's kernel rather than the best one the CPU can run
+//It only needs the physics and DirectXMath, and builds on Linux as well as Windows from the CMakeLists.txt at the top of the repo
+#include "HeadlessScene.h"
+#include "../PhysicsWorld.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+using namespace PhysicsCanvas;
+
+static void WriteTrajectories(std::list<std::shared_ptr<PhysicsBody>>& bodies, std::ostream& out) {
+	out << "body,time,px,py,pz,rx,ry,rz,vx,vy,vz,avx,avy,avz\n";
+	for (std::shared_ptr<PhysicsBody> body : bodies) {
+		for (const Record& r : body->GetTimeKeeper().GetRecords()) {
+			out << body->GetName() << "," << r.time << ","
+				<< r.position.x << "," << r.position.y << "," << r.position.z << ","
+				<< r.rotation.x << "," << r.rotation.y << "," << r.rotation.z << ","
+				<< r.velocity.x << "," << r.velocity.y << "," << r.velocity.z << ","
+				<< r.ang_velocity.x << "," << r.ang_velocity.y << "," << r.ang_velocity.z << "\n";
+		}
+	}
+}
+
+int main(int argc, char* argv[]) {
+	if (argc < 3) {
+		std::cerr << "usage: " << argv[0] << " <scene.psim> <end time in seconds> [trajectories.csv] [-threads n] [-broadphase tree|sap|hash] [-error e] [-history file] [-tolerance t] [-integrator scalar|sse|avx2|avx512]\n";
+		return 1;
+	}
+	const char* scenePath = argv[1];
+	float endTime = (float)atof(argv[2]);
+	const char* outPath = nullptr;
+	unsigned int threads = 0;
+	Broadphase::Type broadphase = Broadphase::DynamicTree;
+	float errorBound = TimeKeeper::DEFAULT_ERROR_BOUND;
+	const char* historyPath = nullptr;
+	float tolerance = 0;
+	for (int i = 3; i < argc; i++) {
+		if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc) {
+			threads = (unsigned int)atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-broadphase") == 0 && i + 1 < argc) {
+			i++;
+			if (strcmp(argv[i], "sap") == 0)
+				broadphase = Broadphase::SweepPrune;
+			else if (strcmp(argv[i], "hash") == 0)
+				broadphase = Broadphase::SpatialHash;
+		}
+		else if (strcmp(argv[i], "-error") == 0 && i + 1 < argc) {
+			errorBound = (float)atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-history") == 0 && i + 1 < argc) {
+			historyPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "-tolerance") == 0 && i + 1 < argc) {
+			tolerance = (float)atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-integrator") == 0 && i + 1 < argc) {
+			i++;
+			for (int k = BatchIntegrator::Scalar; k < BatchIntegrator::KERNEL_COUNT; k++) {
+				if (strcmp(argv[i], BatchIntegrator::Name((BatchIntegrator::Kernel)k)) == 0)
+					BatchIntegrator::SetKernel((BatchIntegrator::Kernel)k);
+			}
+		}
+		else {
+			outPath = argv[i];
+		}
+	}
+
+	std::list<std::shared_ptr<PhysicsBody>> bodies;
+	if (!HeadlessScene::Load(scenePath, bodies)) {
+		std::cerr << "could not open " << scenePath << "\n";
+		return 1;
+	}
+	std::shared_ptr<HistoryFile> history;
+	if (historyPath) {
+		history = std::make_shared<HistoryFile>(historyPath);
+		if (!history->IsOpen()) {
+			std::cerr << "could not create " << historyPath << "\n";
+			return 1;
+		}
+	}
+	//the loaded state is the record at time 0, so that each step's record lands at its own index
+	for (std::shared_ptr<PhysicsBody> b : bodies) {
+		b->GetTimeKeeper().SetErrorBound(errorBound);
+		b->GetTimeKeeper().SetHistoryFile(history);
+		b->GetTimeKeeper().SetRecordingTolerance(tolerance);
+		b->GetTimeKeeper().Wipe({ 0, b->GetPosition(), b->GetRotation(), b->GetVelocity(), b->GetAngularVelocity() });
+	}
+
+	PhysicsWorld world;
+	world.SetBroadphase(broadphase);
+	if (threads != 0)
+		world.SetThreadCount(threads);
+
+	float time = 0;
+	int steps = 0;
+	auto start = std::chrono::steady_clock::now();
+	while (time < endTime) {
+		time = world.Step(bodies, time);
+		steps++;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	fprintf(stderr, "%d steps (%zu bodies, %u threads, %s integrator) in %.3fs, %.0f steps/s\n",
+		steps, bodies.size(), world.GetThreadCount(), BatchIntegrator::Name(BatchIntegrator::GetKernel()),
+		seconds, seconds > 0 ? steps / seconds : 0.0);
+
+	size_t historyBytes = 0, kept = 0, recorded = 0;
+	for (std::shared_ptr<PhysicsBody> b : bodies) {
+		historyBytes += b->GetTimeKeeper().StoredBytes();
+		kept += b->GetTimeKeeper().KeptCount();
+		recorded += b->GetTimeKeeper().GetCount();
+	}
+	size_t fileBytes = history ? history->GetSize() : 0;
+	fprintf(stderr, "history: %zu bytes in memory, %zu in the history file, %.0f bytes per body-second (error bound %g)\n",
+		historyBytes, fileBytes, time > 0 ? (historyBytes + fileBytes) / (bodies.size() * time) : 0.0, errorBound);
+	fprintf(stderr, "kept %zu of %zu steps recorded (tolerance %g)\n", kept, recorded, tolerance);
+
+	if (outPath) {
+		std::ofstream out(outPath);
+		if (!out) {
+			std::cerr << "could not write " << outPath << "\n";
+			return 1;
+		}
+		WriteTrajectories(bodies, out);
+	}
+	else {
+		WriteTrajectories(bodies, std::cout);
+	}
+	return 0;
+}
@@ -0,0 +1,21 @@
+#include "HeadlessScene.h"
+#include "../SimFile.h"
+#include <fstream>
+#include <sstream>
+
+using namespace PhysicsCanvas;
+
+bool HeadlessScene::Load(const char* path, std::list<std::shared_ptr<PhysicsBody>>& bodies) {
+	std::ifstream sceneFile(path);
+	if (!sceneFile)
+		return false;
+	std::stringstream scene;
+	scene << sceneFile.rdbuf();
+
+	bodies = SimFile::Parse(scene.str(), nullptr);
+	PhysicsBody floor;
+	floor.Create(FLOOR, nullptr);
+	floor.GiveName("FLOOR");
+	bodies.push_front(std::make_shared<PhysicsBody>(floor));
+	return true;
+}
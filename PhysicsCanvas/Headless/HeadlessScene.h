@@ -0,0 +1,13 @@
+#pragma once
+#include "../PhysicsBody.h"
+#include <list>
+#include <memory>
+
+namespace PhysicsCanvas {
+	//What the headless runner and benchmarks share: loading a scene and setting it up the same way the editor does
+	class HeadlessScene {
+	public:
+		//the floor first, then the bodies from the .psim file at path, without meshes. False if the file can't be read
+		static bool Load(const char* path, std::list<std::shared_ptr<PhysicsBody>>& bodies);
+	};
+}
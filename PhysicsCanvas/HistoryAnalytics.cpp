@@ -0,0 +1,229 @@
+#include "HistoryAnalytics.h"
+#include <cmath>
+
+using namespace PhysicsCanvas;
+
+namespace {
+	struct ChunkSummary {
+		float min;
+		float max;
+		float minTime;
+		float maxTime;
+		double sum;
+		double integral;
+	};
+
+	const int LANES = 8;	//running totals kept side by side, which the compiler can hold in one vector register
+}
+
+//the lowest, highest and total of count values
+static void Reduce(const float* v, size_t count, float& lowest, float& highest, double& total) {
+	float lo[LANES], hi[LANES], sum[LANES];
+	for (int l = 0; l < LANES; l++) {
+		lo[l] = hi[l] = v[0];
+		sum[l] = 0;
+	}
+	size_t i = 0;
+	for (; i + LANES <= count; i += LANES) {
+		for (int l = 0; l < LANES; l++) {
+			lo[l] = v[i + l] < lo[l] ? v[i + l] : lo[l];
+			hi[l] = v[i + l] > hi[l] ? v[i + l] : hi[l];
+			sum[l] += v[i + l];
+		}
+	}
+	for (; i < count; i++) {
+		lo[0] = v[i] < lo[0] ? v[i] : lo[0];
+		hi[0] = v[i] > hi[0] ? v[i] : hi[0];
+		sum[0] += v[i];
+	}
+	lowest = lo[0];
+	highest = hi[0];
+	total = 0;
+	for (int l = 0; l < LANES; l++) {
+		lowest = lo[l] < lowest ? lo[l] : lowest;
+		highest = hi[l] > highest ? hi[l] : highest;
+		total += sum[l];
+	}
+}
+
+void HistoryAnalytics::ForEachChunk(size_t steps, bool parallel, const std::function<void(size_t, size_t, size_t, Scratch&)>& job) {
+	int chunks = (int)((steps + CHUNK_STEPS - 1) / CHUNK_STEPS);
+	auto run = [&](int begin, int end) {
+		Scratch scratch;
+		for (int c = begin; c < end; c++) {
+			size_t first = c * CHUNK_STEPS;
+			job(c, first, steps - first < CHUNK_STEPS ? steps - first : CHUNK_STEPS, scratch);
+		}
+	};
+	//histories with steps that weren't kept work them out through a cache, so only one thread can read them
+	if (parallel)
+		workers->ParallelFor(chunks, run);
+	else
+		run(0, chunks);
+}
+
+void HistoryAnalytics::Evaluate(PhysicsBody& body, Quantity quantity, size_t first, size_t count, Scratch& scratch) {
+	TimeKeeper& keeper = body.GetTimeKeeper();
+	float m = body.GetMass();
+	std::vector<float>* c = scratch.columns;
+	scratch.values.resize(count);
+	float* out = scratch.values.data();
+
+	if (quantity == Height || quantity == PotentialEnergy) {
+		const float* y = keeper.ReadColumn(TimeKeeper::PositionY, first, count, c[0]).data;
+		float scale = quantity == Height ? 1.0f : m * 9.81f;
+		for (size_t i = 0; i < count; i++)
+			out[i] = y[i] * scale;
+		return;
+	}
+
+	const float* x = keeper.ReadColumn(TimeKeeper::VelocityX, first, count, c[0]).data;
+	const float* y = keeper.ReadColumn(TimeKeeper::VelocityY, first, count, c[1]).data;
+	const float* z = keeper.ReadColumn(TimeKeeper::VelocityZ, first, count, c[2]).data;
+	if (quantity == Speed || quantity == Momentum) {
+		float scale = quantity == Speed ? 1.0f : m;
+		for (size_t i = 0; i < count; i++)
+			out[i] = sqrtf(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]) * scale;
+		return;
+	}
+
+	for (size_t i = 0; i < count; i++)
+		out[i] = 0.5f * m * (x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+	x = keeper.ReadColumn(TimeKeeper::AngVelocityX, first, count, c[0]).data;
+	y = keeper.ReadColumn(TimeKeeper::AngVelocityY, first, count, c[1]).data;
+	z = keeper.ReadColumn(TimeKeeper::AngVelocityZ, first, count, c[2]).data;
+	for (size_t i = 0; i < count; i++)
+		out[i] += 0.5f * m * (x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+	if (quantity == TotalEnergy) {
+		y = keeper.ReadColumn(TimeKeeper::PositionY, first, count, c[1]).data;
+		for (size_t i = 0; i < count; i++)
+			out[i] += m * 9.81f * y[i];
+	}
+}
+
+HistoryAnalytics::Summary HistoryAnalytics::Summarise(PhysicsBody& body, Quantity quantity) {
+	TimeKeeper& keeper = body.GetTimeKeeper();
+	size_t steps = keeper.GetCount();
+	std::vector<ChunkSummary> parts((steps + CHUNK_STEPS - 1) / CHUNK_STEPS);
+	ForEachChunk(steps, keeper.AllKept(), [&](size_t chunk, size_t first, size_t count, Scratch& scratch) {
+		//one step past the chunk as well, for the stretch of the integral between this chunk and the next
+		size_t read = first + count < steps ? count + 1 : count;
+		Evaluate(body, quantity, first, read, scratch);
+		const float* v = scratch.values.data();
+		const float* t = keeper.ReadColumn(TimeKeeper::Time, first, read, scratch.times).data;
+
+		ChunkSummary& part = parts[chunk];
+		Reduce(v, count, part.min, part.max, part.sum);
+		part.integral = 0;
+		for (size_t i = 0; i + 1 < read; i++)
+			part.integral += 0.5 * (v[i] + v[i + 1]) * (t[i + 1] - t[i]);
+		size_t i = 0;
+		while (v[i] != part.min && i + 1 < count) i++;
+		part.minTime = t[i];
+		i = 0;
+		while (v[i] != part.max && i + 1 < count) i++;
+		part.maxTime = t[i];
+	});
+
+	Summary summary = { steps, 0, 0, 0, 0, 0, 0 };
+	for (size_t c = 0; c < parts.size(); c++) {
+		if (c == 0 || parts[c].min < summary.min) {
+			summary.min = parts[c].min;
+			summary.minTime = parts[c].minTime;
+		}
+		if (c == 0 || parts[c].max > summary.max) {
+			summary.max = parts[c].max;
+			summary.maxTime = parts[c].maxTime;
+		}
+		summary.mean += parts[c].sum;
+		summary.integral += parts[c].integral;
+	}
+	summary.mean = steps > 0 ? summary.mean / steps : 0;
+	return summary;
+}
+
+float HistoryAnalytics::FirstCrossing(PhysicsBody& body, Quantity quantity, float threshold) {
+	TimeKeeper& keeper = body.GetTimeKeeper();
+	size_t steps = keeper.GetCount();
+	std::vector<float> crossings((steps + CHUNK_STEPS - 1) / CHUNK_STEPS, -1.0f);
+	ForEachChunk(steps, keeper.AllKept(), [&](size_t chunk, size_t first, size_t count, Scratch& scratch) {
+		size_t read = first + count < steps ? count + 1 : count;
+		Evaluate(body, quantity, first, read, scratch);
+		const float* v = scratch.values.data();
+		for (size_t i = 0; i + 1 < read; i++) {
+			if ((v[i] < threshold) != (v[i + 1] < threshold)) {
+				//somewhere between the two steps, assuming it changes steadily between them
+				const float* t = keeper.ReadColumn(TimeKeeper::Time, first + i, 2, scratch.times).data;
+				crossings[chunk] = t[0] + (threshold - v[i]) / (v[i + 1] - v[i]) * (t[1] - t[0]);
+				break;
+			}
+		}
+	});
+	for (float crossing : crossings) {
+		if (crossing >= 0)
+			return crossing;
+	}
+	return -1;
+}
+
+void HistoryAnalytics::SystemSeries(const std::list<std::shared_ptr<PhysicsBody>>& bodies, SystemQuantity quantity, std::vector<float>& out) {
+	//the floor stands for the ground, with the mass of the whole Earth, which would swamp everything else
+	std::vector<PhysicsBody*> moving;
+	for (std::shared_ptr<PhysicsBody> b : bodies) {
+		if (!b->IsFloor())
+			moving.push_back(b.get());
+	}
+	size_t steps = moving.empty() ? 0 : SIZE_MAX;
+	bool parallel = true;
+	for (PhysicsBody* b : moving) {
+		steps = b->GetTimeKeeper().GetCount() < steps ? b->GetTimeKeeper().GetCount() : steps;
+		parallel = parallel && b->GetTimeKeeper().AllKept();
+	}
+	out.assign(steps, 0.0f);
+	ForEachChunk(steps, parallel, [&](size_t, size_t first, size_t count, Scratch& scratch) {
+		float* total = out.data() + first;
+		if (quantity != SystemMomentum) {
+			for (PhysicsBody* b : moving) {
+				Evaluate(*b, quantity == SystemEnergy ? TotalEnergy : KineticEnergy, first, count, scratch);
+				for (size_t i = 0; i < count; i++)
+					total[i] += scratch.values[i];
+			}
+			return;
+		}
+		//momentum is added up as a vector, so bodies moving opposite ways cancel out
+		for (int axis = 0; axis < 3; axis++)
+			scratch.totals[axis].assign(count, 0.0f);
+		for (PhysicsBody* b : moving) {
+			float m = b->GetMass();
+			for (int axis = 0; axis < 3; axis++) {
+				const float* v = b->GetTimeKeeper().ReadColumn((TimeKeeper::Field)(TimeKeeper::VelocityX + axis), first, count, scratch.values).data;
+				float* sum = scratch.totals[axis].data();
+				for (size_t i = 0; i < count; i++)
+					sum[i] += m * v[i];
+			}
+		}
+		const float* x = scratch.totals[0].data();
+		const float* y = scratch.totals[1].data();
+		const float* z = scratch.totals[2].data();
+		for (size_t i = 0; i < count; i++)
+			total[i] = sqrtf(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+	});
+}
+
+float HistoryAnalytics::EnergyDrift(const std::list<std::shared_ptr<PhysicsBody>>& bodies) {
+	std::vector<float> energy;
+	SystemSeries(bodies, SystemEnergy, energy);
+	float drift = 0;
+	for (float e : energy)
+		drift = fabsf(e - energy[0]) > drift ? fabsf(e - energy[0]) : drift;
+	return drift;
+}
+
+size_t HistoryAnalytics::CollisionCount(PhysicsBody& body) {
+	size_t count = 0;
+	for (auto& timestamp : body.GetTimestamps()) {
+		if (std::get<1>(timestamp).compare(0, 14, "Collision with") == 0)
+			count++;
+	}
+	return count;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "pch.h"
+#include "PhysicsBody.h"
+#include "WorkerPool.h"
+#include <list>
+#include <memory>
+#include <vector>
+
+namespace PhysicsCanvas {
+	//Aggregates over bodies' recorded histories, such as a body's peak speed or the total energy of every body at each step.
+	//Histories are read a column at a time in chunks of whole blocks, which the pool's threads share between them. Each chunk
+	//is reduced on its own and the chunks are combined in order, so the results are the same for any number of threads.
+	//Nothing may be recorded while the histories are being read
+	class HistoryAnalytics {
+	public:
+		static const size_t CHUNK_STEPS = 16 * TimeKeeper::BLOCK_SIZE;
+
+		//quantities of a single body, worked out the same way as in the graph plotter
+		enum Quantity { Height, Speed, Momentum, KineticEnergy, PotentialEnergy, TotalEnergy };
+
+		//quantities of every body together
+		enum SystemQuantity { SystemMomentum, SystemKineticEnergy, SystemEnergy };
+
+		struct Summary {
+			size_t samples;
+			float min;
+			float max;
+			float minTime;			//the first time min and max are reached
+			float maxTime;
+			double mean;
+			double integral;		//over time, by the trapezium rule
+		};
+
+		//threads includes the calling thread, 0 means one per hardware thread
+		HistoryAnalytics(unsigned int threads = 0) : workers(new WorkerPool(threads)) {}
+
+		unsigned int GetThreadCount() { return workers->GetThreadCount(); }
+
+		Summary Summarise(PhysicsBody& body, Quantity quantity);
+
+		//the first time quantity goes from one side of threshold to the other, between the two steps either side of it.
+		//-1 if it never does
+		float FirstCrossing(PhysicsBody& body, Quantity quantity, float threshold);
+
+		//quantity for every step the bodies have all recorded, leaving out the floor
+		void SystemSeries(const std::list<std::shared_ptr<PhysicsBody>>& bodies, SystemQuantity quantity, std::vector<float>& out);
+
+		//the furthest the total energy of the bodies gets from what it started at
+		float EnergyDrift(const std::list<std::shared_ptr<PhysicsBody>>& bodies);
+
+		//how many collisions body has been in
+		static size_t CollisionCount(PhysicsBody& body);
+	private:
+		//columns read from the histories, one set for each thread
+		struct Scratch {
+			std::vector<float> times;
+			std::vector<float> values;
+			std::vector<float> columns[3];
+			std::vector<float> totals[3];
+		};
+
+		//calls job(chunk, first, count, scratch) for every chunk of steps up to steps, on the pool's threads if parallel is set
+		void ForEachChunk(size_t steps, bool parallel, const std::function<void(size_t, size_t, size_t, Scratch&)>& job);
+
+		//works out quantity for count steps of body from step first into scratch.values
+		static void Evaluate(PhysicsBody& body, Quantity quantity, size_t first, size_t count, Scratch& scratch);
+
+		std::unique_ptr<WorkerPool> workers;
+	};
+}
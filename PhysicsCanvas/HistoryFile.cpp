@@ -0,0 +1,124 @@
+#include "HistoryFile.h"
+#include <cstring>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace PhysicsCanvas;
+
+namespace {
+	struct FileHeader {
+		char magic[8];			//"PCHIST1"
+		uint32_t segmentSize;
+		uint32_t blockHeaderSize;
+	};
+
+	struct BlockHeader {
+		uint32_t owner;
+		uint32_t block;
+		float step;				//the TimeKeeper's quantisation step, 0 for plain records
+		uint32_t size;			//bytes of block data after this header
+	};
+}
+
+HistoryFile::HistoryFile(const std::filesystem::path& path, bool temporary) : file_open(false), segmentCount(0), used(0), owners(0) {
+#ifdef _WIN32
+	CREATEFILE2_EXTENDED_PARAMETERS params = { sizeof(params) };
+	params.dwFileAttributes = temporary ? FILE_ATTRIBUTE_TEMPORARY : FILE_ATTRIBUTE_NORMAL;
+	params.dwFileFlags = temporary ? FILE_FLAG_DELETE_ON_CLOSE : 0;
+	file = CreateFile2(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, CREATE_ALWAYS, &params);
+	if (file == INVALID_HANDLE_VALUE)
+		return;
+#else
+	file = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (file < 0)
+		return;
+	if (temporary)
+		unlink(path.c_str());	//it stays until it's closed
+#endif
+	file_open = true;
+	if (!MapSegment()) {
+		file_open = false;
+#ifdef _WIN32
+		CloseHandle(file);
+#else
+		close(file);
+#endif
+		return;
+	}
+	Clear();
+}
+
+HistoryFile::~HistoryFile() {
+	if (!file_open)
+		return;
+	for (int i = 0; i < segmentCount; i++) {
+#ifdef _WIN32
+		UnmapViewOfFile(segments[i]);
+#else
+		munmap(segments[i], SEGMENT_SIZE);
+#endif
+	}
+#ifdef _WIN32
+	CloseHandle(file);
+#else
+	close(file);
+#endif
+}
+
+bool HistoryFile::MapSegment() {
+	if (segmentCount == MAX_SEGMENTS)
+		return false;
+	unsigned long long offset = (unsigned long long)segmentCount * SEGMENT_SIZE;
+	unsigned long long fileSize = offset + SEGMENT_SIZE;
+	void* view;
+#ifdef _WIN32
+	//mapping more than the file holds makes it grow to fit. The view keeps the mapping open after its handle is closed
+	HANDLE mapping = CreateFileMappingFromApp(file, nullptr, PAGE_READWRITE, fileSize, nullptr);
+	if (!mapping)
+		return false;
+	view = MapViewOfFileFromApp(mapping, FILE_MAP_READ | FILE_MAP_WRITE, offset, SEGMENT_SIZE);
+	CloseHandle(mapping);
+	if (!view)
+		return false;
+#else
+	if (ftruncate(file, (off_t)fileSize) != 0)
+		return false;
+	view = mmap(nullptr, SEGMENT_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, file, (off_t)offset);
+	if (view == MAP_FAILED)
+		return false;
+#endif
+	segments[segmentCount] = (uint8_t*)view;
+	segmentCount++;
+	return true;
+}
+
+const uint8_t* HistoryFile::Append(uint32_t owner, uint32_t block, float step, const uint8_t* data, size_t size) {
+	size_t total = sizeof(BlockHeader) + size;
+	if (!file_open || total > SEGMENT_SIZE)
+		return nullptr;
+
+	std::lock_guard<std::mutex> lock(appendLock);
+	//a block that won't fit in what's left of its segment starts the next one
+	if (used % SEGMENT_SIZE + total > SEGMENT_SIZE)
+		used = (used / SEGMENT_SIZE + 1) * SEGMENT_SIZE;
+	if (used / SEGMENT_SIZE >= (size_t)segmentCount && !MapSegment())
+		return nullptr;
+
+	uint8_t* at = segments[used / SEGMENT_SIZE] + used % SEGMENT_SIZE;
+	BlockHeader header = { owner, block, step, (uint32_t)size };
+	memcpy(at, &header, sizeof(header));
+	memcpy(at + sizeof(header), data, size);
+	used += total;
+	return at + sizeof(header);
+}
+
+void HistoryFile::Clear() {
+	if (!file_open)
+		return;
+	FileHeader header = { "PCHIST1", (uint32_t)SEGMENT_SIZE, (uint32_t)sizeof(BlockHeader) };
+	memcpy(segments[0], &header, sizeof(header));
+	used = sizeof(header);
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "pch.h"
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+
+namespace PhysicsCanvas {
+	//An append-only file that TimeKeepers can keep their compressed blocks in rather than in memory, one per simulation and
+	//shared by all of its bodies. The file is mapped into memory a segment at a time, so blocks are read straight out of the
+	//mapping and the system pages them in and out as they are used. No block crosses into the next segment, and segments stay
+	//mapped until the file is closed, so a pointer to a block is good for as long as the file is open.
+	//The file starts with a header and every block has a header of its own saying which body and block it is, so the file
+	//can be read back on its own
+	class HistoryFile {
+	public:
+		static const size_t SEGMENT_SIZE = 64 << 20;	//64MB, a whole number of pages on every system
+		static const int MAX_SEGMENTS = 4096;			//256GB
+
+		//creates the file at path, replacing anything already there. IsOpen() says if it worked.
+		//A temporary file is deleted once it is closed
+		HistoryFile(const std::filesystem::path& path, bool temporary = false);
+
+		~HistoryFile();
+
+		bool IsOpen() { return file_open; }
+
+		//an id for a TimeKeeper to tag its blocks with
+		uint32_t NewOwner() { return owners++; }
+
+		//copies a block into the file and returns where it is in the mapping, or nullptr if the file couldn't grow to fit it
+		const uint8_t* Append(uint32_t owner, uint32_t block, float step, const uint8_t* data, size_t size);
+
+		//starts writing from the beginning again, only once nothing points into the file any more
+		void Clear();
+
+		//the bytes written, including the headers
+		size_t GetSize() { return used; }
+	private:
+		bool MapSegment();
+
+		bool file_open;
+#ifdef _WIN32
+		HANDLE file;
+#else
+		int file;
+#endif
+		uint8_t* segments[MAX_SEGMENTS];
+		std::atomic<int> segmentCount;
+		size_t used;				//where the next block goes
+		std::atomic<uint32_t> owners;
+		std::mutex appendLock;		//bodies seal their blocks from several threads at once
+	};
+}
@@ -8,10 +8,7 @@
 #include <assimp\postprocess.h>
 #include <assimp\scene.h>
 #include <fstream>
-
-#define FLOOR 1
-#define CUBE 2
-#define SPHERE 3
+#include "Shapes.h"
 
 namespace PhysicsCanvas {
 	class Mesh {
@@ -1,11 +1,28 @@
 #pragma once
+#include <memory>
+#include <string>
 
 
 namespace PhysicsCanvas {
 	class PEvent {
 	public:
 		PEvent() : toggle(true) {}
-		static enum eventType {
+
+		//a copy isn't one of the body's events until it's added to it, so changing the copy's times doesn't make the body
+		//sort its events again. It keeps the number though, as the body's lists copy their forces whenever they're saved,
+		//restored or moved, and adding the copy to a body gives it a number of its own anyway
+		PEvent(const PEvent& other) : eType(other.eType), startT(other.startT), endT(other.endT), Id(other.Id), toggle(other.toggle), number(other.number) {}
+		PEvent& operator=(const PEvent& other) {
+			eType = other.eType;
+			startT = other.startT;
+			endT = other.endT;
+			Id = other.Id;
+			toggle = other.toggle;
+			number = other.number;
+			TimingChanged();
+			return *this;
+		}
+		enum eventType {
 			Force,
 		};
 
@@ -14,30 +31,51 @@ namespace PhysicsCanvas {
 				startT = start;
 			if (startT > endT)
 				endT = startT + 1.0f;
+			TimingChanged();
+		}
+		virtual void SetEnd(float end) {
+			if (end > startT) endT = end;
+			TimingChanged();
 		}
-		virtual void SetEnd(float end) { if (end > startT) endT = end; }
 
 		virtual float GetStart() { return startT; }
 		virtual float GetEnd() { return endT; }
 
-		virtual std::string GetId() const { return Id; }
+		virtual const std::string& GetId() const { return Id; }
 		virtual void SetId(std::string id) { Id = id; }
 
+		//the event's number on its body, given when it's added and never given to another of the body's events, so it can
+		//be told apart from the others without comparing IDs, which are only for showing and can be the same. -1 until then
+		int GetNumber() const { return number; }
+		void SetNumber(int n) { number = n; }
+
 		virtual bool GetToggle() { return toggle; }
 		virtual void SetToggle(bool newToggle) { toggle = newToggle; }
 
 		virtual void SetEventType(eventType new_type) {
 			eType = new_type;
+			TimingChanged();
 		}
 
 		virtual eventType GetEventType() { return eType; }
 
 		virtual std::string EData() { return "Empty event"; };
+
+		//the events added to a body share its count of changes to their starts, ends and types, so that the body can tell
+		//when it needs to sort them by time again without looking at every one
+		void ShareRevision(const std::shared_ptr<unsigned int>& revision) { timingRevision = revision; }
+	protected:
+		void TimingChanged() {
+			if (timingRevision)
+				(*timingRevision)++;
+		}
 	private:
+		std::shared_ptr<unsigned int> timingRevision;
 		eventType eType;
 		float startT = 0.0f;
 		float endT = 1.0f;
 		std::string Id;
 		bool toggle;
+		int number = -1;
 	};
 }
\ No newline at end of file
@@ -1,6 +1,5 @@
 #pragma once
 #include "pch.h"
-#include "..\Common\DirectXHelper.h"
 
 using namespace DirectX;
 
@@ -36,9 +35,15 @@ namespace PhysicsCanvas {
 			return abs(Magnitude(vec1) * sinf(acosf(Float3Dot(vec1, vec2) / (Magnitude(vec1) * Magnitude(vec2)))));
 		}
 		static XMFLOAT3 RotateVector(XMFLOAT3 vec, XMFLOAT3 rot) {
+			return RotateVector(vec, RotationQuaternion(rot));
+		}
+		//for rotating many vectors the same way, without working out the sines and cosines again for each
+		static XMVECTOR RotationQuaternion(XMFLOAT3 rot) {
+			return XMQuaternionRotationRollPitchYaw(rot.z, rot.y, rot.x);
+		}
+		static XMFLOAT3 RotateVector(XMFLOAT3 vec, FXMVECTOR rotation) {
 			XMFLOAT3 ret = {};
 			XMVECTOR vector = XMLoadFloat3(&vec);
-			XMVECTOR rotation = XMQuaternionRotationRollPitchYaw(rot.z, rot.y, rot.x);
 			XMVECTOR result = XMVector3Rotate(vector, rotation);
 			XMStoreFloat3(&ret, result);
 			return ret;
@@ -46,5 +51,36 @@ namespace PhysicsCanvas {
 		static float Float3CosTheta(XMFLOAT3 vec1, XMFLOAT3 vec2) {
 			return Float3Dot(vec1, vec2) / (Magnitude(vec1) * Magnitude(vec2));
 		}
+		//slab test of a ray against an axis-aligned box. returns true if the ray enters the box before maxDist, with the entry distance in tEnter
+		static bool RayHitsAABB(XMFLOAT3 origin, XMFLOAT3 dir, XMFLOAT3 minP, XMFLOAT3 maxP, float maxDist, float& tEnter) {
+			float o[3] = { origin.x, origin.y, origin.z };
+			float d[3] = { dir.x, dir.y, dir.z };
+			float mn[3] = { minP.x, minP.y, minP.z };
+			float mx[3] = { maxP.x, maxP.y, maxP.z };
+			float tMin = 0.0f;
+			float tMax = maxDist;
+			for (int i = 0; i < 3; i++) {
+				if (fabsf(d[i]) < 1e-8f) {
+					//parallel to this pair of planes, so it has to start between them
+					if (o[i] < mn[i] || o[i] > mx[i])
+						return false;
+				}
+				else {
+					float t1 = (mn[i] - o[i]) / d[i];
+					float t2 = (mx[i] - o[i]) / d[i];
+					if (t1 > t2) {
+						float temp = t1;
+						t1 = t2;
+						t2 = temp;
+					}
+					if (t1 > tMin) tMin = t1;
+					if (t2 < tMax) tMax = t2;
+					if (tMin > tMax)
+						return false;
+				}
+			}
+			tEnter = tMin;
+			return true;
+		}
 	};
 }
\ No newline at end of file
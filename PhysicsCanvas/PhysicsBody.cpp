@@ -1,11 +1,21 @@
 #include "PhysicsBody.h"
+#include <limits>
 
 using namespace PhysicsCanvas;
 
 void PhysicsBody::Create(const UINT shape, const std::shared_ptr<DX::DeviceResources>& deviceResources) {
-	CreateMesh(shape, deviceResources);
-	position = XMFLOAT3();
-	rotation = XMFLOAT3();
+	//without device resources the body has no mesh, which is all that's needed to simulate it without rendering
+#ifndef PHYSICSCANVAS_HEADLESS
+	if (deviceResources)
+		CreateMesh(shape, deviceResources);
+#else
+	(void)deviceResources;
+#endif
+	BodyStore& store = slot.Store();
+	BodyHandle h = slot.GetHandle();
+	XMFLOAT3 position = XMFLOAT3();
+	XMFLOAT3 rotation = XMFLOAT3();
+	XMFLOAT3 dimensions;
 	obj_type = Kinematic;
 
 	switch (shape) {
@@ -16,7 +26,6 @@ void PhysicsBody::Create(const UINT shape, const std::shared_ptr<DX::DeviceResou
 	case SPHERE:
 		dimensions = XMFLOAT3(1.0f, 1.0f, 1.0f);	//radius from centre is 1 unit in all directions
 		bounds = std::make_shared<BoundingShape>(BoundingShape::Sphere, position, rotation, dimensions);
-		ApplyScale(XMFLOAT3(0.5f, 0.5f, 0.5f));
 		break;
 	case FLOOR:
 		position = XMFLOAT3(0.0f, -2.0f, 0.0f);
@@ -25,111 +34,124 @@ void PhysicsBody::Create(const UINT shape, const std::shared_ptr<DX::DeviceResou
 		isFloor = true;
 		break;
 	}
+	store.Set3(BodyStore::PositionX, h, position);
+	store.Set3(BodyStore::RotationX, h, rotation);
+	store.Set3(BodyStore::DimensionX, h, dimensions);
+	store.SetFlag(h, BodyStore::BoundsStale, true);
+	if (shape == SPHERE)
+		ApplyScale(XMFLOAT3(0.5f, 0.5f, 0.5f));
 	//if its not the floor, give a default mass of 1kg. else, make it very large
 	if (shape != FLOOR) {
-		mass = 1.0f;
-		Force weight(mass);
+		store.Set(BodyStore::Mass, h, 1.0f);
+		Force weight(GetMass());
 		weight.SetFrom(position);
 		AddEvent(std::make_shared<Force>(weight));
 	}
 	else {
-		mass = 5.97e+24; // 5.97*10^24 kg
+		store.Set(BodyStore::Mass, h, 5.97e+24); // 5.97*10^24 kg
 	}
 }
 
 std::string PhysicsBody::BodyData() {
+	XMFLOAT3 dimensions = GetDimensions();
+	//the state the body starts from, exactly as it was set
+	Record initial = timeKeeper.Retrieve(0);
 	std::ostringstream data;
+	//enough digits for every float to be read back as the same float
+	data.precision(std::numeric_limits<float>::max_digits10);
 	data << "OBJECT KINEMATIC\n"
 		<< "NAME " << name << "\n"
-		<< "COL " << _mesh.GetColour().x << " " << _mesh.GetColour().y << " " << _mesh.GetColour().z << "\n"
+		<< "COL " << GetColour().x << " " << GetColour().y << " " << GetColour().z << "\n"
 		<< "SHAPE " << (bounds->GetType() == BoundingShape::Cuboid ? "Cuboid" : "Sphere") << "\n"
 		<< "DIMS " << (bounds->GetType() == BoundingShape::Cuboid ? std::to_string(dimensions.x) + " "
 			+ std::to_string(dimensions.y) + " "
 			+ std::to_string(dimensions.z)
 			: std::to_string(dimensions.x)) << "\n"
-		<< "POS " << timeKeeper.Retrieve(0).position.x << " " << timeKeeper.Retrieve(0).position.y << " " << timeKeeper.Retrieve(0).position.z << "\n"
-		<< "ROT " << timeKeeper.Retrieve(0).rotation.x << " " << timeKeeper.Retrieve(0).rotation.y << " " << timeKeeper.Retrieve(0).rotation.z << "\n"
-		<< "VEL " << timeKeeper.Retrieve(0).velocity.x << " " << timeKeeper.Retrieve(0).velocity.y << " " << timeKeeper.Retrieve(0).velocity.z << "\n"
-		<< "AVEL " << timeKeeper.Retrieve(0).ang_velocity.x << " " << timeKeeper.Retrieve(0).ang_velocity.y << " " << timeKeeper.Retrieve(0).ang_velocity.z << "\n"
-		<< "MASS " << mass << "\n";
-	for (std::shared_ptr<PEvent> e : pEvents) {
-		Force* eForce = dynamic_cast<Force*>(e.get());
-		if (eForce)
-			data << eForce->EData() << "\n";
-	}
+		<< "POS " << initial.position.x << " " << initial.position.y << " " << initial.position.z << "\n"
+		<< "ROT " << initial.rotation.x << " " << initial.rotation.y << " " << initial.rotation.z << "\n"
+		<< "VEL " << initial.velocity.x << " " << initial.velocity.y << " " << initial.velocity.z << "\n"
+		<< "AVEL " << initial.ang_velocity.x << " " << initial.ang_velocity.y << " " << initial.ang_velocity.z << "\n"
+		<< "MASS " << GetMass() << "\n";
+	for (Force* eForce : forceEvents)
+		data << eForce->EData() << "\n";
 	data << "ENDOBJECT\n";
 	return data.str();
 }
 
 void PhysicsBody::SetTransform(XMFLOAT3 pos, XMFLOAT3 rot, XMFLOAT3 scale) {
+	BodyStore& store = slot.Store();
+	BodyHandle h = slot.GetHandle();
+	XMFLOAT3 position = store.Get3(BodyStore::PositionX, h);
+	XMFLOAT3 rotation = store.Get3(BodyStore::RotationX, h);
 	XMFLOAT3 posChange(pos.x - position.x, pos.y - position.y, pos.z - position.z);
 	XMFLOAT3 rotChange(rot.x - rotation.x, rot.y - rotation.y, rot.z - rotation.z);
-	//Update the fromPoint member on all forces
-	for (std::shared_ptr<PEvent> e : pEvents) {
-		Force* eForce = dynamic_cast<Force*>(e.get());
-		if (eForce) {
-			XMFLOAT3 rotPosChange(PhysMaths::RotateVector(PhysMaths::Float3Minus(eForce->GetFrom(), position), rotChange));
-			eForce->SetFrom(PhysMaths::Float3Add(PhysMaths::Float3Add(eForce->GetFrom(), posChange), rotPosChange));
-		}
+	//Update the fromPoint member on all forces, the rotation being the same for all of them
+	XMVECTOR rotQuaternion = PhysMaths::RotationQuaternion(rotChange);
+	for (Force* eForce : forceEvents) {
+		XMFLOAT3 rotPosChange(PhysMaths::RotateVector(PhysMaths::Float3Minus(eForce->GetFrom(), position), rotQuaternion));
+		eForce->SetFrom(PhysMaths::Float3Add(PhysMaths::Float3Add(eForce->GetFrom(), posChange), rotPosChange));
 	}
 
-	position = pos;
-	rotation = rot;
-	dimensions = scale;
+	store.Set3(BodyStore::PositionX, h, pos);
+	store.Set3(BodyStore::RotationX, h, rot);
+	store.Set3(BodyStore::DimensionX, h, scale);
 
-	_mesh.SetWorldMat(position, rotation, dimensions);
-	bounds->SetPosition(position);
-	bounds->SetRotation(rotation);
-	bounds->SetDimensions(dimensions);
+	//the mesh isn't moved here, the renderer places it from the body's transform when it draws it
+	bounds->SetPosition(pos);
+	bounds->SetRotation(rot);
+	bounds->SetDimensions(scale);
+	store.SetFlag(h, BodyStore::BoundsStale, true);
 }
 void PhysicsBody::ApplyTranslation(XMFLOAT3 translation) {
 	if (isFloor) return;
+	XMFLOAT3 position = GetPosition();
 	float _x = position.x + translation.x;
 	float _y = position.y + translation.y;
 	float _z = position.z + translation.z;
-	SetTransform(XMFLOAT3(_x, _y, _z), rotation, dimensions);
+	SetTransform(XMFLOAT3(_x, _y, _z), GetRotation(), GetDimensions());
 }
 void PhysicsBody::ApplyRotation(XMFLOAT3 rot) {
 	if (isFloor) return;
+	XMFLOAT3 rotation = GetRotation();
 	float _roll = rotation.x + rot.x;
 	float _pitch = rotation.z + rot.z;
 	float _yaw = rotation.y + rot.y;
-	SetTransform(position, XMFLOAT3(_roll, _pitch, _yaw), dimensions);
+	SetTransform(GetPosition(), XMFLOAT3(_roll, _yaw, _pitch), GetDimensions());
 }
 void PhysicsBody::ApplyScale(XMFLOAT3 scale_) {
-	dimensions.x = scale_.x;
-	dimensions.y = scale_.y;
-	dimensions.z = scale_.z;
-	SetTransform(position, rotation, dimensions);
+	SetTransform(GetPosition(), GetRotation(), scale_);
 }
 
 void PhysicsBody::SetMass(float m) {
-	mass = m;
-	for (std::shared_ptr<PEvent> e : pEvents) {
-		if (e->GetId() == "Weight") {
-			Force* eForce = dynamic_cast<Force*>(e.get());
-			if (eForce) {
-				eForce->SetDirection(XMFLOAT3(0.0f, -9.81f * mass, 0.0f));
-				return;
-			}
-		}
-	}
+	slot.Store().Set(BodyStore::Mass, slot.GetHandle(), m);
+	if (weightEvent >= 0)
+		forceEvents[weightEvent]->SetDirection(XMFLOAT3(0.0f, -9.81f * m, 0.0f));
 }
 
 
 void PhysicsBody::AddForce(Force::ForceType type_, XMFLOAT3 dir_, float time) {	//if the parameters for a force object are passed in
 	Force f(type_, dir_);
 	f.SetStart(time);
-	forces.push_back(f);
+	AddForce(f);
 }
 
 void PhysicsBody::AddEvent(std::shared_ptr<PEvent> e) {
+	e->ShareRevision(eventRevision);
+	e->SetNumber(nextEventNumber++);
+	(*eventRevision)++;
 	pEvents.push_back(e);
+	//the cast is done the once here, so nothing going through the forces each step needs it
+	Force* eForce = e->GetEventType() == PEvent::Force ? dynamic_cast<Force*>(e.get()) : nullptr;
+	if (eForce) {
+		if (weightEvent < 0 && eForce->GetForceType() == Force::Weight)
+			weightEvent = (int)forceEvents.size();
+		forceEvents.push_back(eForce);
+	}
 }
 
-bool PhysicsBody::HasCollider(std::string n) {
-	for (std::shared_ptr<PhysicsBody> coll : collisions) {
-		if (coll->GetName() == n)
+bool PhysicsBody::HasCollider(BodyHandle collider) {
+	for (const std::shared_ptr<PhysicsBody>& coll : collisions) {
+		if (coll->GetHandle() == collider)
 			return true;
 	}
 	return false;
@@ -137,66 +159,71 @@ bool PhysicsBody::HasCollider(std::string n) {
 
 void PhysicsBody::RegisterCollision(std::shared_ptr<PhysicsBody>& coll, float time) {
 	//Handling reaction forces for the objects having contact
-	std::vector<XMFLOAT3> contacts = bounds->ContactPointsTo(coll->GetBounds());
+	ContactManifold contacts = bounds->ContactPointsTo(coll->GetBounds());
+	BodyHandle collider = coll->GetHandle();
+	XMFLOAT3 position = GetPosition();
 	XMFLOAT3 direction = {};
 	switch (coll->GetBounds()->GetType()) {
 	case BoundingShape::Sphere:
-		direction = { coll->position.x - position.x, coll->position.y - position.y, coll->position.z - position.z };
+		direction = PhysMaths::Float3Minus(coll->GetPosition(), position);
 		break;
 	case BoundingShape::Cuboid:
-		std::vector<CuboidFace> faces = coll->GetBounds()->CuboidFaces();
+		const std::array<CuboidFace, 6>& faces = coll->GetBounds()->CuboidFaces();
+		const std::array<XMFLOAT3, 6>& normals = coll->GetBounds()->CuboidFaceNormals();
 		//check this object's position relative to all of the faces
-		for (CuboidFace face : faces) {
-			if (PhysMaths::Float3CosTheta(
-				coll->GetBounds()->CuboidFaceNormal(face), PhysMaths::Float3Minus(position, BoundingShape::CuboidFaceCentre(face))) >= 0) {
-
-				direction = coll->GetBounds()->CuboidFaceNormal(face);
+		for (int i = 0; i < 6; i++) {
+			if (PhysMaths::Float3CosTheta(normals[i], PhysMaths::Float3Minus(position, BoundingShape::CuboidFaceCentre(faces[i]))) >= 0) {
+				direction = normals[i];
 				break;
 			}
 		}
 		break;
 	}
 	//store perpendicular distance of each contact point from the centre
-	std::vector<float> perpDists;
-	for (XMFLOAT3 Cpoint : contacts) {
-		perpDists.push_back(PhysMaths::PerpendicularDist(PhysMaths::Float3Minus(Cpoint, position), direction));
+	float perpDists[4];
+	for (int c = 0; c < contacts.count; c++) {
+		perpDists[c] = PhysMaths::PerpendicularDist(PhysMaths::Float3Minus(contacts.points[c], position), direction);
 	}
 	float l = 0; //sum of all perDists
-	for (float x : perpDists)
-		l += x;
+	for (int c = 0; c < contacts.count; c++)
+		l += perpDists[c];
 	//magnitude of reaction force, all the reactions will sum to this
-	std::list<Force> allForcesExcludingReaction;
-	for (Force f : ActiveForces(time)) {
-		if (f.GetId().find(/*"Reaction force due to " + */coll->GetName()) == std::string::npos) {
-			allForcesExcludingReaction.push_back(f);
+	XMFLOAT3 allForcesExcludingReaction(0, 0, 0);
+	for (Force* f : ActiveForces(time)) {
+		if (!f->IsFrom(collider)) {
+			allForcesExcludingReaction = PhysMaths::Float3Add(allForcesExcludingReaction, f->GetDirection());
 		}
 	}
-	float reactionMag = abs(PhysMaths::Float3Dot(Force::ResultantF(allForcesExcludingReaction).GetDirection(), direction) / PhysMaths::Magnitude(direction));
+	float reactionMag = abs(PhysMaths::Float3Dot(allForcesExcludingReaction, direction) / PhysMaths::Magnitude(direction));
 	//now to create a reaction force at each contact point, scaling it according to perpendicular distance proportions
 	int index = 0;
-	for (XMFLOAT3 Cpoint : contacts) {
-		std::ostringstream fName;
-		fName << "Reaction force due to " + coll->GetName() + "(" << index << ")";
-		Force reaction(Force::Reaction,
-			PhysMaths::VecTimesByConstant(direction, (perpDists[perpDists.size() - index - 1] / l) * (reactionMag / PhysMaths::Magnitude(direction)))
-		);
-		reaction.SetId(fName.str());
-		reaction.SetFrom(Cpoint);
-		reaction.SetColour(XMFLOAT3(1, 0.1, 0.1));
+	for (int c = 0; c < contacts.count; c++) {
+		XMFLOAT3 Cpoint = contacts.points[c];
+		//if every contact is in line with the centre (e.g. a single point right below it) they share the reaction equally
+		float share = l > 0 ? perpDists[contacts.count - index - 1] / l : 1.0f / contacts.count;
+		XMFLOAT3 reactionDir = PhysMaths::VecTimesByConstant(direction, share * (reactionMag / PhysMaths::Magnitude(direction)));
 		bool flag0 = false;
 		for (Force& f : forces) {
-			if (f.GetId() == reaction.GetId()) {
+			if (f.GetForceType() == Force::Reaction && f.IsFrom(collider, index)) {
 				flag0 = true;
-				f = reaction;
+				f.SetDirection(reactionDir);
+				f.SetFrom(Cpoint);
+				f.SetToggle(true);
 				break;
 			}
 		}
-		if (!flag0)
-			forces.push_back(reaction);
-		fName.flush();
+		if (!flag0) {
+			//the ID is only for showing, so it's only made for a new contact
+			Force reaction(Force::Reaction, reactionDir);
+			reaction.SetId("Reaction force due to " + coll->GetName() + "(" + std::to_string(index) + ")");
+			reaction.SetCollider(collider, index);
+			reaction.SetFrom(Cpoint);
+			reaction.SetColour(XMFLOAT3(1, 0.1, 0.1));
+			AddForce(reaction);
+		}
 		index++;
 	}
-	if (!HasCollider(coll->GetName())) {
+	if (!HasCollider(collider)) {
 		collisions.push_back(coll);
 		timestamps.push_back(std::make_tuple(time, "Collision with " + coll->GetName()));
 		//find direction from this to coll
@@ -208,32 +235,33 @@ void PhysicsBody::RegisterCollision(std::shared_ptr<PhysicsBody>& coll, float ti
 
 		Force f(Force::Impulse, XMFLOAT3(dir.x, dir.y, dir.z));
 		f.SetStart(time);
-		std::string fName = "Collision force due to " + coll->GetName();
-		f.SetId(fName);
 		f.SetFrom(position);
-		std::ostringstream outstr;
+		f.SetCollider(collider, -1);
 		bool flag = false;
 		for (Force& f0 : forces) {
-			if (f0.GetId() == fName) {
+			if (f0.GetForceType() == Force::Impulse && f0.IsFrom(collider, -1)) {
 				flag = true;
+				f.SetId(f0.GetId());
+				f.SetNumber(f0.GetNumber());
 				f0 = f;
 				break;
 			}
 		}
-		if (!flag)
+		if (!flag) {
+			f.SetId("Collision force due to " + coll->GetName());
 			AddForce(f);
+		}
 	}
 
 }
 
-void PhysicsBody::UpdateCollisionForces(float time) {
+void PhysicsBody::UpdateCollisionForces(float) {
 	for (std::vector<std::shared_ptr<PhysicsBody>>::iterator coll = collisions.begin(); coll != collisions.end();) {
 		//if this body is no longer colliding with a body with which collisions were registered,
-		for (Force& f : forces) {											//find the force which this collision caused
-			if (!BoundingShape::PointCollidingWithObject(f.GetFrom(), (*coll)->GetBounds())) {
-				if (f.GetId().find((*coll)->GetName()) != std::string::npos) {	//if we find it, and it has not already been deactivated,
-					f.SetToggle(false);
-				}
+		BodyHandle collider = (*coll)->GetHandle();
+		for (Force& f : forces) {											//find the forces which this collision caused
+			if (f.IsFrom(collider) && !BoundingShape::PointCollidingWithObject(f.GetFrom(), (*coll)->GetBounds())) {
+				f.SetToggle(false);
 			}
 		}
 		if (!BoundingShape::IsColliding(bounds, (*coll)->GetBounds())) {
@@ -245,40 +273,37 @@ void PhysicsBody::UpdateCollisionForces(float time) {
 }
 
 XMFLOAT3 PhysicsBody::Torque(float time) {
+	return TorqueOf(ActiveForces(time));
+}
+
+XMFLOAT3 PhysicsBody::TorqueOf(const std::vector<Force*>& active) {
+	XMFLOAT3 position = GetPosition();
 	XMFLOAT3 resultant(0, 0, 0);
-	for (Force f : ActiveForces(time)) {
+	for (Force* f : active) {
 		XMFLOAT3 axis = PhysMaths::Float3Cross(
-			XMFLOAT3(position.x - f.GetFrom().x, position.y - f.GetFrom().y, position.z - f.GetFrom().z), f.GetDirection());
+			XMFLOAT3(position.x - f->GetFrom().x, position.y - f->GetFrom().y, position.z - f->GetFrom().z), f->GetDirection());
 
 		resultant = { resultant.x + axis.x, resultant.y + axis.y, resultant.z + axis.z };
 	}
 	return resultant;
 }
 
-std::list<Force> PhysicsBody::ActiveForces(float time) {
-	std::list<Force> activeForces;
-	for (std::shared_ptr<PEvent> e : pEvents) {
-		if (e->GetEventType() == PEvent::Force && e->GetToggle()) {
-			Force* eForce = dynamic_cast<Force*>(e.get());
-			if (eForce) {
-				if (time >= eForce->GetStart()) {
-					if (eForce->GetForceType() == Force::Weight || time < eForce->GetEnd()) {
-						activeForces.push_back(*eForce);
-					}
-				}
-			}
-		}
+const std::vector<Force*>& PhysicsBody::ActiveForces(float time) {
+	activeForces.clear();
+	for (int i : timeline.ActiveForces(forceEvents, *eventRevision, time)) {
+		if (forceEvents[i]->GetToggle())
+			activeForces.push_back(forceEvents[i]);
 	}
-	for (Force f : forces) {
+	for (Force& f : forces) {
 		if (time >= f.GetStart()) {
 			//if if it's a reaction force OR if it's a different type that is still meant to be applied
 			if (f.GetForceType() == Force::Reaction) {
 				if (f.GetToggle())
-					activeForces.push_back(f);
+					activeForces.push_back(&f);
 			}
 			else {
 				if (f.GetEnd() <= time)
-					activeForces.push_back(f);
+					activeForces.push_back(&f);
 			}
 		}
 	}
@@ -286,47 +311,118 @@ std::list<Force> PhysicsBody::ActiveForces(float time) {
 }
 
 void PhysicsBody::Step(float time) {
-	if (timeKeeper.Retrieve(time) != NULL_RECORD) {
-		TimeJump(time);
+	BeginStep(time);
+	Integrate(time);
+	EndStep(time);
+}
+
+void PhysicsBody::BeginStep(float time) {
+	replaying = timeKeeper.Retrieve(time) != NULL_RECORD;
+	if (!replaying)
+		UpdateCollisionForces(time);
+}
+
+void PhysicsBody::Integrate(float time) {
+	BodyHandle h = slot.GetHandle();
+	Accelerate(time);
+	slot.Store().AdvanceLinear(h, h + 1, 0.001f);	//each step increases time by 0.001s
+	Translate(time);
+	slot.Store().AdvanceAngular(h, h + 1, 0.001f);
+	Turn(time);
+}
+
+void PhysicsBody::Accelerate(float time) {
+	BodyStore& store = slot.Store();
+	BodyHandle h = slot.GetHandle();
+	//same as TimeJump(), but the collision forces are left for EndStep()
+	if (replaying) {
+		Record r = timeKeeper.Retrieve(time);
+		SetTransform(r.position, r.rotation, GetDimensions());
+		store.Set3(BodyStore::VelocityX, h, r.velocity);
+		store.Set3(BodyStore::AngVelocityX, h, r.ang_velocity);
+		store.SetFlag(h, BodyStore::Integrating, false);
 		return;
 	}
-	UpdateCollisionForces(time);
 
-	Force sumF = Force::ResultantF(ActiveForces(time));
-	XMFLOAT3 a = sumF / mass;	// acceleration = Force / mass
-	velocity.x = velocity.x + (a.x * 0.001f);	//each step increases time by 0.001s
-	velocity.y = velocity.y + (a.y * 0.001f);	//calculating u for next Step()
-	velocity.z = velocity.z + (a.z * 0.001f);	//v = u + at
-	//s = ut + 1/2 at^2
-	XMFLOAT3 translation(
-		(velocity.x * 0.001f) + (0.5f * a.x * 0.001f * 0.001f),
-		(velocity.y * 0.001f) + (0.5f * a.y * 0.001f * 0.001f),
-		(velocity.z * 0.001f) + (0.5f * a.z * 0.001f * 0.001f)
-	);
-	ApplyTranslation(translation);
-
-	XMFLOAT3 ang_a = PhysMaths::VecDivByConstant(Torque(time), mass);
-	ang_velocity.x += ang_a.x * 0.001f;
-	ang_velocity.y += ang_a.y * 0.001f;
-	ang_velocity.z += ang_a.z * 0.001f;
-	//theta = omega(t) + 1/2 aplha(t)^2
-	XMFLOAT3 rot(
-		(ang_velocity.x * 0.001f) + (0.5f * ang_a.x * 0.001f * 0.001f),
-		(ang_velocity.y * 0.001f) + (0.5f * ang_a.y * 0.001f * 0.001f),
-		(ang_velocity.z * 0.001f) + (0.5f * ang_a.z * 0.001f * 0.001f)
-	);
-	ApplyRotation(rot);
-
-	timeKeeper.RecordData(time, position, rotation, velocity, ang_velocity);
+	//what's acting is worked out once for the step, Translate() uses the same list for the torque
+	XMFLOAT3 sumF(0, 0, 0);
+	for (Force* f : ActiveForces(time)) {
+		XMFLOAT3 dir = f->GetDirection();
+		sumF = { sumF.x + dir.x, sumF.y + dir.y, sumF.z + dir.z };
+	}
+	store.Set3(BodyStore::AccelerationX, h, PhysMaths::VecDivByConstant(sumF, GetMass()));	// acceleration = Force / mass
+	store.SetFlag(h, BodyStore::Integrating, true);
+}
+
+void PhysicsBody::Translate(float) {
+	BodyStore& store = slot.Store();
+	BodyHandle h = slot.GetHandle();
+	if (!store.HasFlag(h, BodyStore::Integrating))
+		return;
+	//the store has carried the velocity on and worked out s = ut + 1/2 at^2
+	ApplyTranslation(store.Get3(BodyStore::TranslationX, h));
+	//the torque is about where the body has moved to, from the forces Accelerate() found
+	store.Set3(BodyStore::AngAccelerationX, h, PhysMaths::VecDivByConstant(TorqueOf(activeForces), GetMass()));
+}
+
+void PhysicsBody::Turn(float time) {
+	BodyStore& store = slot.Store();
+	BodyHandle h = slot.GetHandle();
+	if (store.HasFlag(h, BodyStore::Integrating)) {
+		//theta = omega(t) + 1/2 aplha(t)^2, from the store the same way as the translation
+		ApplyRotation(store.Get3(BodyStore::TurnX, h));
+
+		//the steps where a force starts or stops or a collision happens are always kept, the motion isn't smooth across them
+		bool keyframe = (!timestamps.empty() && std::get<0>(timestamps.back()) > time - 0.0015f)
+			|| timeline.ChangesBetween(forceEvents, *eventRevision, time - 0.001f, time);
+		timeKeeper.RecordData(time, GetPosition(), GetRotation(), GetVelocity(), GetAngularVelocity(), keyframe);
+		store.SetFlag(h, BodyStore::Integrating, false);
+	}
+	//done here, while the bodies are split across the workers, rather than by the broadphase one body at a time
+	RefreshBounds();
+}
+
+void PhysicsBody::EndStep(float time) {
+	if (replaying)
+		UpdateCollisionForces(time);
 }
 
 void PhysicsBody::TimeJump(float time) {
 	if (timeKeeper.Retrieve(time) == NULL_RECORD)
 		return;
 
-	Record& r = timeKeeper.Retrieve(time);
-	SetTransform(r.position, r.rotation, dimensions);
-	velocity = r.velocity;
-	ang_velocity = r.ang_velocity;
+	Record r = timeKeeper.Retrieve(time);
+	SetTransform(r.position, r.rotation, GetDimensions());
+	SetVelocity(r.velocity);
+	SetAngVelocity(r.ang_velocity);
 	UpdateCollisionForces(time);
 }
+
+void PhysicsBody::RefreshBounds() {
+	BodyStore& store = slot.Store();
+	BodyHandle h = slot.GetHandle();
+	if (!store.HasFlag(h, BodyStore::BoundsStale))
+		return;
+	store.Set3(BodyStore::MinX, h, bounds->GetMinPoint());
+	store.Set3(BodyStore::MaxX, h, bounds->GetMaxPoint());
+	store.SetFlag(h, BodyStore::BoundsStale, false);
+}
+
+BodyState PhysicsBody::SaveState(float time) {
+	BodyState state = { { time, GetPosition(), GetRotation(), GetVelocity(), GetAngularVelocity() }, forces, collisions, timestamps, {} };
+	for (Force* eForce : forceEvents)
+		state.eventPoints.push_back(eForce->GetFrom());
+	return state;
+}
+
+void PhysicsBody::RestoreState(const BodyState& state) {
+	SetTransform(state.record.position, state.record.rotation, GetDimensions());
+	for (size_t i = 0; i < forceEvents.size() && i < state.eventPoints.size(); i++)
+		forceEvents[i]->SetFrom(state.eventPoints[i]);
+	SetVelocity(state.record.velocity);
+	SetAngVelocity(state.record.ang_velocity);
+	forces = state.forces;
+	collisions = state.collisions;
+	timestamps = state.timestamps;
+	timeKeeper.Truncate(state.record);
+}
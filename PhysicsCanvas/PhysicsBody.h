@@ -1,12 +1,20 @@
 #pragma once
 #include "pch.h"
-#include "..\Common\DeviceResources.h"
-#include "..\Common\DirectXHelper.h"
+#ifndef PHYSICSCANVAS_HEADLESS
+#include "Common/DeviceResources.h"
+#include "Common/DirectXHelper.h"
 #include "Mesh.h"
+#else
+//built without Direct3D, bodies have no mesh and device resources are only ever passed around as null
+namespace DX { class DeviceResources; }
+#endif
+#include "Shapes.h"
 #include <list>
 #include "PEvent.h"
 #include "Force.h"
 #include "BoundingShape.h"
+#include "BodyStore.h"
+#include "EventTimeline.h"
 #include "PhysMaths.h"
 #include "TimeKeeper.h"
 #include <sstream>
@@ -14,19 +22,35 @@
 using namespace DirectX;
 
 namespace PhysicsCanvas {
+	class PhysicsBody;
+
+	//everything about a body that changes as it is simulated, so it can be put back to how it was at that time
+	struct BodyState {
+		Record record;
+		std::list<Force> forces;
+		std::vector<std::shared_ptr<PhysicsBody>> collisions;
+		std::vector<std::tuple<float, std::string>> timestamps;
+		std::vector<XMFLOAT3> eventPoints;	//where each of the force events acts from, as they move with the body
+	};
+
+	//A body in the scene. The state that changes every step (position, rotation, velocities, mass and size) lives in a
+	//BodyStore at the body's handle, the store of the world that steps it, so the passes over every body can run down the
+	//store's arrays; the rest, which is only looked at a body at a time, is kept here
 	class PhysicsBody {
 	public:
-		static enum o_type {
+		enum o_type {
 			Kinematic,
 		};
 
+		//deviceResources can be null for a body that is only simulated and never rendered
 		virtual void Create(const UINT shape, const std::shared_ptr<DX::DeviceResources>& deviceResources);
 
-		std::string GetName() { return name; }
+		const std::string& GetName() { return name; }
 		void GiveName(std::string n) { name = n; }
 
 		o_type GetType() { return obj_type; }
 
+#ifndef PHYSICSCANVAS_HEADLESS
 		virtual void CreateMesh(const UINT shape, const std::shared_ptr<DX::DeviceResources>& deviceResources) {
 			_mesh.Create(shape, deviceResources);
 		}
@@ -35,6 +59,11 @@ namespace PhysicsCanvas {
 		}
 		Mesh& GetMesh() { return _mesh; }
 
+		XMFLOAT3 GetColour() { return _mesh.GetColour(); }
+#else
+		XMFLOAT3 GetColour() { return XMFLOAT3(0.1f, 0.6f, 0.1f); }	//what a mesh is made with
+#endif
+
 		std::string BodyData();
 
 		void SetTransform(XMFLOAT3 pos, XMFLOAT3 rot, XMFLOAT3 scale);
@@ -45,35 +74,49 @@ namespace PhysicsCanvas {
 
 		void ApplyScale(XMFLOAT3 scale_);
 
-		float GetMass() { return mass; }
+		BodyHandle GetHandle() { return slot.GetHandle(); }
+
+		BodyStore& GetStore() { return slot.Store(); }
+
+		//moves the body's state into store, which gives it a new handle. A world does this to the bodies it steps, so a handle
+		//kept from before a body's first step in a world doesn't find it any more
+		void MoveTo(const std::shared_ptr<BodyStore>& store) { slot.MoveTo(store); }
+
+		float GetMass() { return slot.Store().Get(BodyStore::Mass, slot.GetHandle()); }
+
+		bool IsFloor() { return isFloor; }
 
 		void SetMass(float m);
 
-		XMFLOAT3 GetPosition() { return position; }
+		XMFLOAT3 GetPosition() { return slot.Store().Get3(BodyStore::PositionX, slot.GetHandle()); }
 		
-		XMFLOAT3 GetRotation() { return rotation; }
+		XMFLOAT3 GetRotation() { return slot.Store().Get3(BodyStore::RotationX, slot.GetHandle()); }
 		
-		XMFLOAT3 GetDimensions() { return dimensions; }
+		XMFLOAT3 GetDimensions() { return slot.Store().Get3(BodyStore::DimensionX, slot.GetHandle()); }
 		
-		XMFLOAT3 GetVelocity() { return velocity; }
+		XMFLOAT3 GetVelocity() { return slot.Store().Get3(BodyStore::VelocityX, slot.GetHandle()); }
 		
-		void SetVelocity(XMFLOAT3 vel) { velocity = vel; }
+		void SetVelocity(XMFLOAT3 vel) { slot.Store().Set3(BodyStore::VelocityX, slot.GetHandle(), vel); }
 		
-		XMFLOAT3 GetAngularVelocity() { return ang_velocity; }
+		XMFLOAT3 GetAngularVelocity() { return slot.Store().Get3(BodyStore::AngVelocityX, slot.GetHandle()); }
 		
-		void SetAngVelocity(XMFLOAT3 aVel) { ang_velocity = aVel; }
+		void SetAngVelocity(XMFLOAT3 aVel) { slot.Store().Set3(BodyStore::AngVelocityX, slot.GetHandle(), aVel); }
 		
 		std::list<Force>& GetForces() { return forces; }
 		
-		std::vector<std::shared_ptr<PEvent>> GetEvents() { return pEvents; }
+		const std::vector<std::shared_ptr<PEvent>>& GetEvents() { return pEvents; }
+
+		//the events that are forces, in the order they were added
+		const std::vector<Force*>& GetForceEvents() { return forceEvents; }
 		
-		std::shared_ptr<BoundingShape> GetBounds() { return bounds; }
+		const std::shared_ptr<BoundingShape>& GetBounds() { return bounds; }
 		
 		TimeKeeper& GetTimeKeeper() { return timeKeeper; }
 		
 		std::vector<std::tuple<float, std::string>>& GetTimestamps() { return timestamps; }
 
 		void AddForce(Force f) {	//if a whole force object is passed in
+			f.SetNumber(nextEventNumber++);
 			forces.push_back(f);
 		}
 
@@ -81,7 +124,10 @@ namespace PhysicsCanvas {
 
 		void AddEvent(std::shared_ptr<PEvent> e);
 
-		bool HasCollider(std::string n);
+		//goes up whenever an event is added or one of the events' times changes
+		unsigned int GetEventRevision() { return *eventRevision; }
+
+		bool HasCollider(BodyHandle collider);
 
 		void RegisterCollision(std::shared_ptr<PhysicsBody>& coll, float time);
 
@@ -89,34 +135,65 @@ namespace PhysicsCanvas {
 
 		XMFLOAT3 Torque(float time);
 
-		std::list<Force> ActiveForces(float time);
+		//the forces acting at time, pointing at the body's own events and forces rather than copies of them. The list is
+		//reused by the next call, and adding or removing forces can leave it pointing at ones that have gone
+		const std::vector<Force*>& ActiveForces(float time);
 
 		void Step(float time);
 
+		//Step() split up so that bodies can be integrated in parallel. BeginStep() and EndStep() look at the bodies this one
+		//is colliding with, so they must run for every body before or after any body integrates. Integrate() only touches this body.
+		void BeginStep(float time);
+
+		void Integrate(float time);
+
+		//Integrate() split up again, so the velocities can be carried on for every body at once by the store in between:
+		//Accelerate(), then BodyStore::AdvanceLinear(), Translate(), BodyStore::AdvanceAngular() and Turn()
+		void Accelerate(float time);
+
+		void Translate(float time);
+
+		void Turn(float time);
+
+		void EndStep(float time);
+
+		//works out the box around the body's bounds into the store, if it has moved since it was last worked out
+		void RefreshBounds();
+
 		void TimeJump(float time);
 
+		BodyState SaveState(float time);
+
+		//puts the body back to how it was when state was saved, and drops its history from after then
+		void RestoreState(const BodyState& state);
+
 		XMFLOAT3 Momentum() {
+			float mass = GetMass();
+			XMFLOAT3 velocity = GetVelocity();
 			return XMFLOAT3(mass * velocity.x, mass * velocity.y, mass * velocity.z);
 		}
 
 		float KineticEnergy() {
-			return (0.5f * mass * pow(PhysMaths::Magnitude(velocity), 2)) + (0.5f * mass * pow(PhysMaths::Magnitude(ang_velocity), 2));
+			float mass = GetMass();
+			return (0.5f * mass * pow(PhysMaths::Magnitude(GetVelocity()), 2)) + (0.5f * mass * pow(PhysMaths::Magnitude(GetAngularVelocity()), 2));
 		}
 
 		float RelativeGPEnergy() {
-			return (mass * 9.81 * position.y);
+			return (GetMass() * 9.81 * GetPosition().y);
 		}
 		
 		void ReleaseResources() {
+#ifndef PHYSICSCANVAS_HEADLESS
 			_mesh.ReleaseResources();
+#endif
 		}
 		
 	private:
+#ifndef PHYSICSCANVAS_HEADLESS
 		Mesh _mesh;
+#endif
 		std::string name;
-		XMFLOAT3 position;
-		XMFLOAT3 rotation;
-		XMFLOAT3 dimensions;
+		BodySlot slot;
 
 		o_type obj_type;
 
@@ -126,14 +203,28 @@ namespace PhysicsCanvas {
 		std::shared_ptr<BoundingShape> bounds;
 		bool isFloor = false;
 		std::list<Force> forces;
-		XMFLOAT3 velocity;
-		XMFLOAT3 ang_velocity;
-		float mass;
 		float volume;
 
 		std::vector<std::shared_ptr<PEvent>> pEvents;
+		//the events of each type in a list of their own, in the order they were added, so going through the forces doesn't
+		//need every event's type checked. Forces are the only type so far
+		std::vector<Force*> forceEvents;
+		int weightEvent = -1;	//the body's weight in forceEvents, so it doesn't have to be looked for by name
+		int nextEventNumber = 0;	//for the next event or force added
 		TimeKeeper timeKeeper;
 		std::vector<std::tuple<float, std::string>> timestamps;
+
+		bool replaying = false;	//this step already has recorded data, so it is loaded rather than simulated
+
+		//sum of the torques from the forces, about where the body is now
+		XMFLOAT3 TorqueOf(const std::vector<Force*>& active);
+
+		//the events sorted by time, so the ones acting don't have to be looked for among all of them each step
+		EventTimeline timeline;
+		std::shared_ptr<unsigned int> eventRevision = std::make_shared<unsigned int>(0);
+
+		//kept between steps so that working out the forces on the body doesn't allocate once they've grown big enough
+		std::vector<Force*> activeForces;
 	};
 
 }
\ No newline at end of file
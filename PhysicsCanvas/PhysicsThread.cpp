@@ -0,0 +1,140 @@
+#include "PhysicsThread.h"
+#include "PhysicsWorld.h"
+#include <chrono>
+
+using namespace PhysicsCanvas;
+
+PhysicsThread::PhysicsThread(std::function<void()> step_, std::function<void(WorldSnapshot&)> snapshot_)
+	: step(step_), snapshot(snapshot_), refresh(false), running(false), stopping(false), speed(1.0f), substepCap(100), simRate(0),
+	thread(&PhysicsThread::Loop, this) {}
+
+PhysicsThread::~PhysicsThread() {
+	{
+		std::lock_guard<std::mutex> lock(signalLock);
+		stopping = true;
+	}
+	wake.notify_one();
+	thread.join();
+}
+
+void PhysicsThread::SetRunning(bool run) {
+	{
+		std::lock_guard<std::mutex> lock(signalLock);
+		if (running == run)
+			return;
+		running = run;
+	}
+	wake.notify_one();
+}
+
+void PhysicsThread::SetSpeed(float simSpeed, int maxSubsteps) {
+	std::lock_guard<std::mutex> lock(signalLock);
+	speed = simSpeed;
+	substepCap = maxSubsteps > 0 ? maxSubsteps : 1;
+}
+
+void PhysicsThread::Submit(std::function<void()> command) {
+	{
+		std::lock_guard<std::mutex> lock(signalLock);
+		commands.push_back(command);
+	}
+	wake.notify_one();
+}
+
+void PhysicsThread::Refresh() {
+	{
+		std::lock_guard<std::mutex> lock(signalLock);
+		refresh = true;
+	}
+	wake.notify_one();
+}
+
+void PhysicsThread::Loop() {
+	typedef std::chrono::steady_clock Clock;
+	Clock::time_point last = Clock::now();
+	double accumulator = 0;
+	double rateWall = 0, rateSim = 0;
+	std::vector<std::function<void()>> pending;
+
+	while (true) {
+		bool run;
+		bool publish;
+		float simSpeed;
+		int maxSubsteps;
+		{
+			std::unique_lock<std::mutex> lock(signalLock);
+			wake.wait(lock, [this] { return stopping || running || refresh || !commands.empty(); });
+			if (stopping)
+				return;
+			pending.swap(commands);
+			publish = refresh || !pending.empty();
+			refresh = false;
+			run = running;
+			simSpeed = speed;
+			maxSubsteps = substepCap;
+		}
+
+		if (!pending.empty()) {
+			std::lock_guard<std::recursive_mutex> lock(worldLock);
+			for (std::function<void()>& command : pending)
+				command();
+			pending.clear();
+		}
+
+		Clock::time_point now = Clock::now();
+		double elapsed = std::chrono::duration<double>(now - last).count();
+		last = now;
+		if (!run) {
+			accumulator = 0;
+			rateWall = rateSim = 0;
+			simRate = 0;
+			//while running, the next batch of steps shows the change
+			if (publish) {
+				{
+					std::lock_guard<std::recursive_mutex> lock(worldLock);
+					snapshot(snapshots.Back());
+				}
+				snapshots.Publish();
+			}
+			continue;
+		}
+
+		//bank the time since the last pass (scaled by the speed) and spend it in whole steps, the remainder carries over
+		int steps = maxSubsteps;
+		if (simSpeed > 0) {
+			accumulator += elapsed * simSpeed;
+			steps = 0;
+			while (accumulator >= PhysicsWorld::STEP_SIZE && steps < maxSubsteps) {
+				accumulator -= PhysicsWorld::STEP_SIZE;
+				steps++;
+			}
+			//if the steps can't keep up, drop the backlog instead of letting it grow and making every following pass slower
+			if (steps == maxSubsteps)
+				accumulator = 0;
+		}
+
+		if (steps == 0) {
+			//nothing due yet, sleep until the next step is
+			std::this_thread::sleep_for(std::chrono::duration<double>((PhysicsWorld::STEP_SIZE - accumulator) / simSpeed));
+		}
+		else {
+			//the lock is taken per step so the UI never waits for more than one
+			for (int i = 0; i < steps; i++) {
+				std::lock_guard<std::recursive_mutex> lock(worldLock);
+				step();
+			}
+			{
+				std::lock_guard<std::recursive_mutex> lock(worldLock);
+				snapshot(snapshots.Back());
+			}
+			snapshots.Publish();
+		}
+
+		rateWall += elapsed;
+		rateSim += steps * PhysicsWorld::STEP_SIZE;
+		if (rateWall >= 0.5) {
+			simRate = (float)(rateSim / rateWall);
+			rateWall = rateSim = 0;
+		}
+	}
+}
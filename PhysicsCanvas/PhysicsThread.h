@@ -0,0 +1,148 @@
+#pragma once
+#include "pch.h"
+#include "Broadphase.h"
+#include "PlotSeries.h"
+#include "TripleBuffer.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace DirectX;
+
+namespace PhysicsCanvas {
+	struct BodyTransform {
+		std::shared_ptr<PhysicsBody> body;
+		XMFLOAT3 position;
+		XMFLOAT3 rotation;
+		XMFLOAT3 dimensions;
+	};
+
+	//a body's row in the time manager's sequencer: the starts of its events and its collisions, in frames
+	struct TimelineRow {
+		std::string name;
+		std::vector<int32_t> keyframes;
+	};
+
+	//an event in the time manager's lists of what's acting now and what the last jump in time went past
+	struct EventSpan {
+		std::string body;
+		std::string id;
+		float start;
+		float end;
+	};
+
+	//an event or a force acting on the selected body, as the object manager shows it. event is the one it was copied from,
+	//for edits to be queued on, and is null for the forces acting that aren't one of the body's events
+	struct EventView {
+		std::shared_ptr<PEvent> event;
+		int number;
+		std::string id;
+		float start;
+		float end;
+		bool toggle;
+		PEvent::eventType type;
+		Force::ForceType forceType;	//if it's a force
+		XMFLOAT3 direction;
+		XMFLOAT3 from;
+		XMFLOAT3 colour;
+		float magnitude;
+	};
+
+	//the selected body's state, events and the forces acting on it now
+	struct BodyView {
+		std::shared_ptr<PhysicsBody> body;
+		std::string name;
+		XMFLOAT3 position;
+		XMFLOAT3 rotation;
+		XMFLOAT3 velocity;
+		XMFLOAT3 angVelocity;
+		XMFLOAT3 dimensions;
+		float mass;
+		std::shared_ptr<BoundingShape> bounds;	//a copy, so it doesn't move while it's drawn
+		XMFLOAT3 resultant;
+		XMFLOAT3 torque;
+		std::vector<EventView> events;
+		std::vector<EventView> acting;
+	};
+
+	//Everything the renderer draws and the panels show after a batch of steps or a change, so none of it has to be read
+	//from the bodies while the physics thread is using them. Bodies are in body list order
+	struct WorldSnapshot {
+		float time = 0;
+		float latestTime = 0;
+		std::vector<BodyTransform> bodies;
+		std::vector<TimelineRow> timeline;
+		std::vector<EventSpan> acting;
+		std::vector<EventSpan> passed;
+		bool hasSelected = false;
+		BodyView selected;
+
+		Broadphase::Type broadphase = Broadphase::DynamicTree;
+		unsigned int threads = 1;
+		bool historyOnDisk = false;
+		float recordingTolerance = 0;
+
+		//the quantities being plotted for each body. Each snapshot keeps its own and brings them up to date from the
+		//bodies' history when it's taken, so only the steps since it was last taken are worked out. Cleared when the
+		//history is wiped, which plotWipes counts
+		std::map<PhysicsBody*, PlotSeries> plots;
+		unsigned int plotWipes = 0;
+	};
+
+	//Runs the simulation on its own thread so that stepping and drawing don't hold each other up.
+	//After each batch of steps, and after any commands when it's paused, a snapshot is published that the renderer can
+	//read without waiting. Anything else that reads or changes the bodies has to hold WorldLock(), which the thread only
+	//holds for one step or command at a time. Edits are best queued with Submit() to run on the thread between steps.
+	class PhysicsThread {
+	public:
+		//step advances the simulation by one fixed step, snapshot fills in the transforms. Both run on the physics thread with the world locked
+		PhysicsThread(std::function<void()> step, std::function<void(WorldSnapshot&)> snapshot);
+
+		~PhysicsThread();
+
+		void SetRunning(bool run);
+
+		//simSpeed is simulated seconds per wall-clock second, 0 runs as fast as possible. maxSubsteps caps the steps between snapshots
+		void SetSpeed(float simSpeed, int maxSubsteps);
+
+		//runs command on the physics thread before its next step, whether or not it is running
+		void Submit(std::function<void()> command);
+
+		//publishes a new snapshot even if the thread is paused, for after an edit made with WorldLock() held
+		void Refresh();
+
+		std::recursive_mutex& WorldLock() { return worldLock; }
+
+		//the most recently published snapshot, for the render thread only
+		WorldSnapshot& LatestSnapshot() { return snapshots.Read(); }
+
+		//simulated seconds actually run per wall-clock second, measured over the last half second
+		float SimRate() { return simRate.load(); }
+	private:
+		void Loop();
+
+		std::function<void()> step;
+		std::function<void(WorldSnapshot&)> snapshot;
+
+		std::recursive_mutex worldLock;
+		TripleBuffer<WorldSnapshot> snapshots;
+
+		//guards the fields below and wakes the thread when any of them change
+		std::mutex signalLock;
+		std::condition_variable wake;
+		std::vector<std::function<void()>> commands;
+		bool refresh;
+		bool running;
+		bool stopping;
+		float speed;
+		int substepCap;
+
+		std::atomic<float> simRate;
+		std::thread thread;	//last, so it starts once everything else is set up
+	};
+}
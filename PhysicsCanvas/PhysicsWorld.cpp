@@ -0,0 +1,123 @@
+#include "PhysicsWorld.h"
+#include <cmath>
+
+using namespace PhysicsCanvas;
+
+const float PhysicsWorld::STEP_SIZE = 0.001f;
+const int PhysicsWorld::CHECKPOINT_STEPS = 100;
+const int PhysicsWorld::RECENT_CHECKPOINTS = 16;
+
+float PhysicsWorld::Step(std::list<std::shared_ptr<PhysicsBody>>& bodies, float time) {
+	for (std::shared_ptr<PhysicsBody>& body : bodies)
+		body->MoveTo(store);
+	//only the pairs the broadphase reports can be colliding, and each of them is only reported once
+	broadphase->Update(bodies);
+	for (const BodyPair& pair : broadphase->CandidatePairs()) {
+		std::shared_ptr<PhysicsBody>& body1 = broadphase->GetBody(pair.first);
+		std::shared_ptr<PhysicsBody>& body2 = broadphase->GetBody(pair.second);
+		//if body1 is colliding with body2
+		if (BoundingShape::IsColliding(body1->GetBounds(), body2->GetBounds())) {
+			//resolve from both sides, as each body pushes the other out
+			std::array<XMFLOAT3, 2> translations = BoundingShape::ResolveCollisions(body1->GetBounds(), body2->GetBounds());
+			body1->ApplyTranslation(translations[0]);
+			body2->ApplyTranslation(translations[1]);
+
+			body1->RegisterCollision(body2, time);
+			body2->RegisterCollision(body1, time);
+
+			translations = BoundingShape::ResolveCollisions(body2->GetBounds(), body1->GetBounds());
+			body2->ApplyTranslation(translations[0]);
+			body1->ApplyTranslation(translations[1]);
+
+			body2->RegisterCollision(body1, time);
+			body1->RegisterCollision(body2, time);
+		}
+	}
+	//worked out from the number of steps rather than added on, as adding 1ms to a float over and over drifts off the step it's on
+	long long stepIndex = llround(time / (double)STEP_SIZE) + 1;
+	time = (float)(stepIndex * (double)STEP_SIZE);
+
+	//collision forces depend on where the other bodies are, so they are all updated before anything moves.
+	//in between, each body's integration only touches its own state so the bodies are split across the workers.
+	//The velocities and how far they move the bodies are carried on by the store for every body at once, running straight
+	//down its arrays, in between the parts that need the body's forces
+	stepBodies.clear();
+	for (std::shared_ptr<PhysicsBody>& body : bodies)
+		stepBodies.push_back(body.get());
+	for (PhysicsBody* body : stepBodies)
+		body->BeginStep(time);
+	int slots = (int)store->Size();
+	workers->ParallelFor((int)stepBodies.size(), [this, time](int begin, int end) {
+		for (int i = begin; i < end; i++)
+			stepBodies[i]->Accelerate(time);
+	});
+	workers->ParallelFor(slots, [this](int begin, int end) {
+		store->AdvanceLinear(begin, end, STEP_SIZE);
+	});
+	workers->ParallelFor((int)stepBodies.size(), [this, time](int begin, int end) {
+		for (int i = begin; i < end; i++)
+			stepBodies[i]->Translate(time);
+	});
+	workers->ParallelFor(slots, [this](int begin, int end) {
+		store->AdvanceAngular(begin, end, STEP_SIZE);
+	});
+	workers->ParallelFor((int)stepBodies.size(), [this, time](int begin, int end) {
+		for (int i = begin; i < end; i++)
+			stepBodies[i]->Turn(time);
+	});
+	for (PhysicsBody* body : stepBodies)
+		body->EndStep(time);
+
+	//replayed steps don't bring the forces and collisions back, so only simulated ones are checkpointed
+	if (stepIndex % CHECKPOINT_STEPS == 0 && (checkpoints.empty() || time > checkpoints.back().time + STEP_SIZE / 2))
+		Checkpoint(bodies, time);
+	return time;
+}
+
+void PhysicsWorld::Checkpoint(std::list<std::shared_ptr<PhysicsBody>>& bodies, float time) {
+	while (!checkpoints.empty() && checkpoints.back().time > time - STEP_SIZE / 2)
+		checkpoints.pop_back();
+	WorldCheckpoint checkpoint;
+	checkpoint.time = time;
+	for (std::shared_ptr<PhysicsBody>& body : bodies)
+		checkpoint.bodies.push_back(body->SaveState(time));
+	checkpoints.push_back(checkpoint);
+	ThinCheckpoints();
+}
+
+void PhysicsWorld::ThinCheckpoints() {
+	//checkpoints are numbered by how many CHECKPOINT_STEPS in they are, so whether one is kept doesn't depend on when the
+	//others were taken. As a checkpoint gets older the spacing only grows, so one that's dropped would never be kept later
+	const double interval = CHECKPOINT_STEPS * (double)STEP_SIZE;
+	long long newest = (long long)floor(checkpoints.back().time / interval + 0.5);
+	size_t kept = 0;
+	for (size_t i = 0; i < checkpoints.size(); i++) {
+		long long number = (long long)floor(checkpoints[i].time / interval + 0.5);
+		long long age = newest - number;
+		long long spacing = 1;
+		while (age >= (spacing * 2 - 1) * RECENT_CHECKPOINTS)
+			spacing *= 2;
+		if (number % spacing == 0) {
+			if (kept != i)
+				checkpoints[kept] = std::move(checkpoints[i]);
+			kept++;
+		}
+	}
+	checkpoints.resize(kept);
+}
+
+float PhysicsWorld::Rewind(std::list<std::shared_ptr<PhysicsBody>>& bodies, float time) {
+	//the states are matched to the bodies by their order, so a checkpoint is no use once a body has been added or removed
+	while (!checkpoints.empty() && (checkpoints.back().time > time + STEP_SIZE / 2 || checkpoints.back().bodies.size() != bodies.size()))
+		checkpoints.pop_back();
+	if (checkpoints.empty())
+		return -1;
+
+	const WorldCheckpoint& checkpoint = checkpoints.back();
+	int i = 0;
+	for (std::shared_ptr<PhysicsBody>& body : bodies) {
+		body->RestoreState(checkpoint.bodies[i]);
+		i++;
+	}
+	return checkpoint.time;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "pch.h"
+#include "PhysicsBody.h"
+#include "Broadphase.h"
+#include "EventIndex.h"
+#include "WorkerPool.h"
+#include <list>
+#include <vector>
+
+namespace PhysicsCanvas {
+	//The physics step on its own, without anything to do with rendering, so that the editor and the headless runner advance
+	//a simulation in exactly the same way
+	class PhysicsWorld {
+	public:
+		static const float STEP_SIZE;	//each step moves time on by 1ms
+		static const int CHECKPOINT_STEPS;	//every body's state is saved this many steps apart
+		static const int RECENT_CHECKPOINTS;	//how many of the newest checkpoints are all kept before they're thinned out
+
+		PhysicsWorld() : store(std::make_shared<BodyStore>()), broadphase(Broadphase::Create(Broadphase::DynamicTree)), workers(new WorkerPool()) {}
+
+		//handles the collisions at time, then integrates every body to the next step. Returns the new time.
+		//Bodies not in the world's store yet are moved into it first
+		float Step(std::list<std::shared_ptr<PhysicsBody>>& bodies, float time);
+
+		Broadphase& GetBroadphase() { return *broadphase; }
+
+		void SetBroadphase(Broadphase::Type type) { broadphase = Broadphase::Create(type); }
+
+		unsigned int GetThreadCount() { return workers->GetThreadCount(); }
+
+		//0 means one thread per hardware thread. Results are the same for any number of threads, only the speed changes
+		void SetThreadCount(unsigned int threads) { workers = std::unique_ptr<WorkerPool>(new WorkerPool(threads)); }
+
+		//saves every body's state at time, in place of any checkpoints from then on. Step() takes one every CHECKPOINT_STEPS
+		//when it simulates past the last one, so a change to the history only has to be simulated again from the one before it.
+		//Older checkpoints are thinned out, see ThinCheckpoints()
+		void Checkpoint(std::list<std::shared_ptr<PhysicsBody>>& bodies, float time);
+
+		size_t GetCheckpointCount() { return checkpoints.size(); }
+
+		//puts every body back to the last checkpoint at or before time and drops everything after it.
+		//Returns the checkpoint's time, or -1 if there isn't one for these bodies
+		float Rewind(std::list<std::shared_ptr<PhysicsBody>>& bodies, float time);
+
+		void ClearCheckpoints() { checkpoints.clear(); }
+
+		//every body's events by time, brought up to date with the bodies first
+		const EventIndex& Events(std::list<std::shared_ptr<PhysicsBody>>& bodies) {
+			events.Sync(bodies);
+			return events;
+		}
+	private:
+		// The state of the bodies this world steps, so a step only integrates them and not any other world's
+		std::shared_ptr<BodyStore> store;
+
+		// Finds the pairs of bodies that need a collision check each step
+		std::unique_ptr<Broadphase> broadphase;
+
+		// Integrates the bodies in parallel, stepBodies is the body list flattened so it can be split up
+		std::unique_ptr<WorkerPool> workers;
+		std::vector<PhysicsBody*> stepBodies;
+
+		// The bodies' states in list order, oldest first
+		struct WorldCheckpoint {
+			float time;
+			std::vector<BodyState> bodies;
+		};
+		std::vector<WorldCheckpoint> checkpoints;
+
+		//The newest RECENT_CHECKPOINTS are all kept, then every 2nd of the next RECENT_CHECKPOINTS * 2, every 4th of the
+		//RECENT_CHECKPOINTS * 4 after that and so on, so the number kept only grows with the log of how long the simulation
+		//has run, while an edit near the current time still has a checkpoint close before it
+		void ThinCheckpoints();
+
+		EventIndex events;
+	};
+}
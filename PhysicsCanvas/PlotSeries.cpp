@@ -0,0 +1,81 @@
+#include "PlotSeries.h"
+
+using namespace PhysicsCanvas;
+
+//works out quantity from a vector's three columns for the steps from first up to count, onto the end of values
+template <typename F>
+static void ExtendFromVector(TimeKeeper& keeper, TimeKeeper::Field x, size_t first, size_t count, std::vector<float>* columns,
+	std::vector<float>& values, F quantity) {
+	TimeKeeper::Span xs = keeper.ReadColumn(x, first, count - first, columns[0]);
+	TimeKeeper::Span ys = keeper.ReadColumn((TimeKeeper::Field)(x + 1), first, count - first, columns[1]);
+	TimeKeeper::Span zs = keeper.ReadColumn((TimeKeeper::Field)(x + 2), first, count - first, columns[2]);
+	values.reserve(first + xs.size);
+	for (size_t i = 0; i < xs.size; i++)
+		values.push_back(quantity(XMFLOAT3(xs[i], ys[i], zs[i])));
+}
+
+void PlotSeries::Update(PhysicsBody& body, Quantity quantity) {
+	Invalidate(body);
+	TimeKeeper& keeper = body.GetTimeKeeper();
+	size_t count = keeper.GetCount();
+
+	size_t settledNow = keeper.SettledCount();
+	size_t first = times.size() < timesSettled ? times.size() : timesSettled;
+	TimeKeeper::Span ts = keeper.ReadColumn(TimeKeeper::Time, first, count - first, columns[0]);
+	times.resize(first);
+	times.insert(times.end(), ts.begin(), ts.end());
+	timesSettled = settledNow;
+
+	std::vector<float>& values = series[quantity];
+	first = values.size() < settled[quantity] ? values.size() : settled[quantity];
+	values.resize(first);
+	pyramids[quantity].Truncate(first);
+	settled[quantity] = settledNow;
+	float m = mass;
+	switch (quantity) {
+	case Displacement: {
+		XMFLOAT3 start = keeper.Retrieve(0).position;
+		ExtendFromVector(keeper, TimeKeeper::PositionX, first, count, columns, values, [&](XMFLOAT3 p) { return PhysMaths::Distance(start, p); });
+		break;
+	}
+	case Speed:
+		ExtendFromVector(keeper, TimeKeeper::VelocityX, first, count, columns, values, [](XMFLOAT3 v) { return PhysMaths::Magnitude(v); });
+		break;
+	case Momentum:
+		ExtendFromVector(keeper, TimeKeeper::VelocityX, first, count, columns, values, [=](XMFLOAT3 v) { return PhysMaths::Magnitude(v) * m; });
+		break;
+	case KineticEnergy: {
+		auto energy = [=](XMFLOAT3 v) { return 0.5f * m * PhysMaths::Float3Dot(v, v); };
+		ExtendFromVector(keeper, TimeKeeper::VelocityX, first, count, columns, values, energy);
+		//the rotational part is added on in place, as there's nothing to keep it in
+		std::vector<float> rotational;
+		ExtendFromVector(keeper, TimeKeeper::AngVelocityX, first, count, columns, rotational, energy);
+		for (size_t i = 0; i < rotational.size() && first + i < values.size(); i++)
+			values[first + i] += rotational[i];
+		break;
+	}
+	case GravitationalPE: {
+		TimeKeeper::Span ys = keeper.ReadColumn(TimeKeeper::PositionY, first, count - first, columns[1]);
+		values.reserve(first + ys.size);
+		for (float y : ys)
+			values.push_back(m * 9.81f * y);
+		break;
+	}
+	default:
+		break;
+	}
+	pyramids[quantity].Extend(values);
+}
+
+void PlotSeries::Invalidate(PhysicsBody& body) {
+	TimeKeeper& keeper = body.GetTimeKeeper();
+	if (keeper.GetRevision() == revision && body.GetMass() == mass)
+		return;
+	//a new mass changes every value, though it comes with a truncation back to the start anyway
+	size_t unchanged = body.GetMass() == mass ? keeper.UnchangedSince(revision) : 0;
+	revision = keeper.GetRevision();
+	mass = body.GetMass();
+	timesSettled = timesSettled < unchanged ? timesSettled : unchanged;
+	for (size_t& s : settled)
+		s = s < unchanged ? s : unchanged;
+}
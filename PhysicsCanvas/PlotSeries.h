@@ -0,0 +1,42 @@
+#pragma once
+#include "pch.h"
+#include "PhysicsBody.h"
+#include "SeriesPyramid.h"
+#include <vector>
+
+namespace PhysicsCanvas {
+	//The quantities the graph plotter shows for a body, a value for every step of its history. Values are kept once they're
+	//worked out, so bringing a quantity up to date only works out the steps recorded since, along with any from where the
+	//history was last truncated. A quantity isn't worked out at all until it's asked for
+	class PlotSeries {
+	public:
+		enum Quantity { Displacement, Speed, Momentum, KineticEnergy, GravitationalPE, QUANTITY_COUNT };
+
+		PlotSeries() : timesSettled(0), settled(), revision(0), mass(0) {}
+
+		//brings the times and quantity up to date with body's history
+		void Update(PhysicsBody& body, Quantity quantity);
+
+		const std::vector<float>& GetTimes() { return times; }
+		const std::vector<float>& Get(Quantity quantity) { return series[quantity]; }
+
+		//the points of quantity worth drawing between times xMin and xMax across pixels pixels
+		void Decimate(Quantity quantity, double xMin, double xMax, int pixels, SeriesPyramid::Method method,
+			std::vector<float>& outX, std::vector<float>& outY) {
+			pyramids[quantity].Decimate(times, series[quantity], xMin, xMax, pixels, method, outX, outY);
+		}
+	private:
+		//drops the values of any steps that have changed since they were worked out
+		void Invalidate(PhysicsBody& body);
+
+		std::vector<float> times;
+		std::vector<float> series[QUANTITY_COUNT];
+		SeriesPyramid pyramids[QUANTITY_COUNT];
+		//how many of the values had settled when they were worked out, the rest are worked out again next time
+		size_t timesSettled;
+		size_t settled[QUANTITY_COUNT];
+		uint32_t revision;		//of the body's history when the values were worked out
+		float mass;
+		std::vector<float> columns[3];	//read from the history, kept so they aren't allocated again every frame
+	};
+}
@@ -0,0 +1,158 @@
+#include "SeriesPyramid.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace PhysicsCanvas;
+
+void SeriesPyramid::Truncate(size_t first) {
+	built = first < built ? first : built;
+}
+
+void SeriesPyramid::Extend(const std::vector<float>& values) {
+	size_t count = values.size();
+	for (size_t i = 0;; i++) {
+		size_t size = (size_t)1 << (i + FIRST_LEVEL);
+		size_t buckets = (count + size - 1) / size;
+		if (i > 0 && levels[i - 1].size() <= 1) {
+			levels.resize(i);	//the level below already covers everything in one bucket
+			break;
+		}
+		if (levels.size() == i)
+			levels.emplace_back();
+		std::vector<Bucket>& level = levels[i];
+		//the bucket the first changed value is in might have been partly filled, so it's worked out again too
+		size_t from = built / size;
+		level.resize(from < level.size() ? from : level.size());
+		for (size_t b = level.size(); b < buckets; b++) {
+			Bucket bucket;
+			if (i == 0) {
+				size_t end = (b + 1) * size < count ? (b + 1) * size : count;
+				bucket.min = bucket.max = (uint32_t)(b * size);
+				for (size_t v = b * size + 1; v < end; v++) {
+					if (values[v] < values[bucket.min]) bucket.min = (uint32_t)v;
+					if (values[v] > values[bucket.max]) bucket.max = (uint32_t)v;
+				}
+			}
+			else {
+				const std::vector<Bucket>& below = levels[i - 1];
+				bucket = below[2 * b];
+				if (2 * b + 1 < below.size()) {
+					const Bucket& other = below[2 * b + 1];
+					if (values[other.min] < values[bucket.min]) bucket.min = other.min;
+					if (values[other.max] > values[bucket.max]) bucket.max = other.max;
+				}
+			}
+			level.push_back(bucket);
+		}
+		if (buckets <= 1)
+			break;
+	}
+	built = count;
+}
+
+void SeriesPyramid::Pick(size_t first, size_t last, int level) {
+	picked.clear();
+	if (level < 0) {
+		for (size_t i = first; i <= last; i++)
+			picked.push_back((uint32_t)i);
+		return;
+	}
+	int shift = level + FIRST_LEVEL;
+	for (size_t b = first >> shift; b <= last >> shift; b++) {
+		//in the order they come, so the line goes through them left to right
+		Bucket bucket = levels[level][b];
+		uint32_t a = bucket.min < bucket.max ? bucket.min : bucket.max;
+		uint32_t c = bucket.min < bucket.max ? bucket.max : bucket.min;
+		picked.push_back(a);
+		if (c != a)
+			picked.push_back(c);
+	}
+}
+
+//picks threshold of the points in, keeping the first and last, choosing from each bucket of the rest the one making the
+//largest triangle with the point picked before it and the average of the next bucket
+static void ThinByTriangles(const std::vector<float>& xs, const std::vector<float>& ys, const std::vector<uint32_t>& in, size_t threshold,
+	std::vector<uint32_t>& out) {
+	out.clear();
+	if (in.size() <= threshold || threshold < 3) {
+		out = in;
+		return;
+	}
+	out.push_back(in[0]);
+	double every = (double)(in.size() - 2) / (threshold - 2);
+	uint32_t a = in[0];
+	for (size_t i = 0; i < threshold - 2; i++) {
+		size_t avgStart = (size_t)((i + 1) * every) + 1;
+		size_t avgEnd = (size_t)((i + 2) * every) + 1;
+		avgEnd = avgEnd < in.size() ? avgEnd : in.size();
+		double avgX = 0, avgY = 0;
+		for (size_t j = avgStart; j < avgEnd; j++) {
+			avgX += xs[in[j]];
+			avgY += ys[in[j]];
+		}
+		avgX /= avgEnd - avgStart;
+		avgY /= avgEnd - avgStart;
+
+		size_t start = (size_t)(i * every) + 1;
+		size_t end = (size_t)((i + 1) * every) + 1;
+		double largest = -1;
+		uint32_t best = in[start];
+		for (size_t j = start; j < end; j++) {
+			double area = fabs((xs[a] - avgX) * (ys[in[j]] - ys[a]) - (xs[a] - xs[in[j]]) * (avgY - ys[a]));
+			if (area > largest) {
+				largest = area;
+				best = in[j];
+			}
+		}
+		out.push_back(best);
+		a = best;
+	}
+	out.push_back(in.back());
+}
+
+void SeriesPyramid::Decimate(const std::vector<float>& xs, const std::vector<float>& ys, double xMin, double xMax, int pixels, Method method,
+	std::vector<float>& outX, std::vector<float>& outY) {
+	outX.clear();
+	outY.clear();
+	size_t count = xs.size() < ys.size() ? xs.size() : ys.size();
+	count = count < built ? count : built;
+	if (count == 0)
+		return;
+	pixels = pixels > 1 ? pixels : 1;
+
+	//the points either side of the view as well, so the line carries on off the edges rather than stopping short of them
+	size_t first = std::lower_bound(xs.begin(), xs.begin() + count, (float)xMin) - xs.begin();
+	size_t last = std::upper_bound(xs.begin(), xs.begin() + count, (float)xMax) - xs.begin();
+	first = first > 0 ? first - 1 : 0;
+	last = last < count ? last : count - 1;
+	if (last < first)
+		last = first;
+
+	//the finest level that gives no more than two points per pixel, each bucket giving two
+	size_t visible = last - first + 1;
+	int level = -1;
+	auto points = [&](int l) { return l < 0 ? visible : 2 * (visible >> (l + FIRST_LEVEL)); };
+	while (points(level) > 2 * (size_t)pixels && level + 1 < (int)levels.size())
+		level++;
+	if (method == LargestTriangle) {
+		Pick(first, last, level - 2 >= 0 ? level - 2 : -1);
+		ThinByTriangles(xs, ys, picked, 2 * pixels, thinned);
+		picked.swap(thinned);
+	}
+	else {
+		Pick(first, last, level);
+	}
+
+	if (picked.empty() || picked.front() > 0) {
+		outX.push_back(xs[0]);
+		outY.push_back(ys[0]);
+	}
+	for (uint32_t i : picked) {
+		outX.push_back(xs[i]);
+		outY.push_back(ys[i]);
+	}
+	if (picked.empty() || picked.back() < count - 1) {
+		outX.push_back(xs[count - 1]);
+		outY.push_back(ys[count - 1]);
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "pch.h"
+#include <cstdint>
+#include <vector>
+
+namespace PhysicsCanvas {
+	//Picks out the points of a plotted series worth drawing, so drawing it costs about the same however long it gets.
+	//Each level splits the series into buckets twice the size of the ones in the level below, and keeps where the lowest and
+	//highest values in each bucket are, so a spike only a step long still shows at every level. Drawing uses the level with
+	//about one bucket per pixel across the part of the series in view
+	class SeriesPyramid {
+	public:
+		enum Method { MinMax, LargestTriangle };
+
+		SeriesPyramid() : built(0) {}
+
+		//the values from first on are about to change, so the buckets they're in have to be worked out again
+		void Truncate(size_t first);
+
+		//brings the buckets up to date with values, which can only have changed from where it was last truncated
+		void Extend(const std::vector<float>& values);
+
+		//the points of (xs, ys) to draw for xMin to xMax across pixels pixels, xs in order. The first and last points are
+		//always included, so fitting the plot to what's drawn still fits the whole series.
+		//LargestTriangle picks the points that keep the shape of the line best from the level below the one MinMax would use
+		void Decimate(const std::vector<float>& xs, const std::vector<float>& ys, double xMin, double xMax, int pixels, Method method,
+			std::vector<float>& outX, std::vector<float>& outY);
+	private:
+		static const int FIRST_LEVEL = 2;		//buckets of 4 values, smaller ones aren't worth keeping
+		struct Bucket {
+			uint32_t min;						//indices of the lowest and highest values
+			uint32_t max;
+		};
+		void Pick(size_t first, size_t last, int level);
+
+		std::vector<std::vector<Bucket>> levels;	//levels[i] has buckets of 1 << (i + FIRST_LEVEL) values
+		size_t built;								//the values the buckets were worked out from
+		std::vector<uint32_t> picked, thinned;		//kept so they aren't allocated again every frame
+	};
+}
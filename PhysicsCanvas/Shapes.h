@@ -0,0 +1,6 @@
+#pragma once
+
+//the shapes a body, and its mesh, can be made as
+#define FLOOR 1
+#define CUBE 2
+#define SPHERE 3
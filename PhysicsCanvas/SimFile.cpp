@@ -0,0 +1,135 @@
+#include "SimFile.h"
+
+using namespace PhysicsCanvas;
+
+std::list<std::shared_ptr<PhysicsBody>> SimFile::Parse(const std::string& data, const std::shared_ptr<DX::DeviceResources>& deviceResources) {
+	std::istringstream dss(data);
+	//read file contents into a variable
+	std::vector<std::string> lines;
+	while (dss) {
+		std::string line;
+		std::getline(dss, line);
+		lines.push_back(line);
+	}
+	//process contents to load simulation
+	std::list<std::shared_ptr<PhysicsBody>> bodies;
+	PhysicsBody b;
+	std::vector<std::shared_ptr<PEvent>> events;
+	std::shared_ptr<PEvent> e;
+	DirectX::XMFLOAT3 float3Buffer;
+	Force* eForce = dynamic_cast<Force*>(e.get());
+	for (std::string l : lines) {
+		//split the string into a list
+		std::istringstream d(l);
+		std::vector<std::string> words;
+		std::string word;
+		while (std::getline(d, word, ' ')) {
+			words.push_back(word);
+		}
+		if (words.size() > 0) {
+			//to process the line, go through its words one by one
+			if (words[0] == "OBJECT") {
+				if (words[1] == "KINEMATIC") {/*No need to make changes if this is a kinematic body since its the default*/ }
+			}
+			else if (words[0] == "NAME") {
+				std::string name = "";
+				for (int i = 1; i < (int)words.size(); i++) {
+					name += words[i] + " ";
+				}
+				name = name.substr(0, name.size() - 1); //get rid of extra space
+				b.GiveName(name);
+			}
+			else if (words[0] == "COL") {
+				float3Buffer = { std::stof(words[1].c_str()), std::stof(words[2].c_str()), std::stof(words[3].c_str()) };
+			}
+			else if (words[0] == "SHAPE") {
+				b.Create(words[1] == "Cuboid" ? CUBE : SPHERE, deviceResources);
+			}
+			else if (words[0] == "DIMS") {
+				switch (b.GetBounds()->GetType()) {
+				case BoundingShape::Cuboid:
+					b.ApplyScale(XMFLOAT3(std::stof(words[1].c_str()), std::stof(words[2].c_str()), std::stof(words[3].c_str())));
+					break;
+				case BoundingShape::Sphere:
+					b.ApplyScale(XMFLOAT3(std::stof(words[1].c_str()), std::stof(words[1].c_str()), std::stof(words[1].c_str())));
+					break;
+				}
+			}
+			else if (words[0] == "POS") {
+				b.ApplyTranslation(XMFLOAT3(std::stof(words[1].c_str()), std::stof(words[2].c_str()), std::stof(words[3].c_str())));
+			}
+			else if (words[0] == "ROT") {
+				b.ApplyRotation(XMFLOAT3(std::stof(words[1].c_str()), std::stof(words[2].c_str()), std::stof(words[3].c_str())));
+			}
+			else if (words[0] == "VEL") {
+				b.SetVelocity(XMFLOAT3(std::stof(words[1].c_str()), std::stof(words[2].c_str()), std::stof(words[3].c_str())));
+			}
+			else if (words[0] == "AVEL") {
+				b.SetAngVelocity(XMFLOAT3(std::stof(words[1].c_str()), std::stof(words[2].c_str()), std::stof(words[3].c_str())));
+			}
+			else if (words[0] == "MASS") {
+				b.SetMass(std::stof(words[1].c_str()));
+			}
+			//handle adding events from the file data
+			else if (words[0] == "EVENT") {
+				if (words[1] == "FORCE") {
+					e = std::make_shared<Force>(Force::Constant, XMFLOAT3());
+					eForce = dynamic_cast<Force*>(e.get());
+				}
+			}
+			else if (words[0] == "ID") {
+				std::string id = "";
+				for (int i = 1; i < (int)words.size(); i++) {
+					id += words[i] + " ";
+				}
+				id = id.substr(0, id.size() - 1); //get rid of extra space
+				e->SetId(id);
+			}
+			else if (words[0] == "START") {
+				e->SetStart(std::stof(words[1].c_str()));
+			}
+			else if (words[0] == "FTYPE") {
+				if (eForce) {
+					if (words[1] == "Constant")
+						eForce->SetForceType(Force::Constant);
+					else if (words[1] == "Impulse")
+						eForce->SetForceType(Force::Impulse);
+				}
+			}
+			else if (words[0] == "END") {
+				e->SetEnd(std::stof(words[1].c_str()));
+			}
+			else if (words[0] == "DIR") {
+				if (eForce)
+					eForce->SetDirection(XMFLOAT3(std::stof(words[1].c_str()), std::stof(words[2].c_str()), std::stof(words[3].c_str())));
+			}
+			else if (words[0] == "FROM") {
+				if (eForce)
+					eForce->SetFrom(XMFLOAT3(std::stof(words[1].c_str()), std::stof(words[2].c_str()), std::stof(words[3].c_str())));
+			}
+			else if (words[0] == "ENDEVENT") {
+				events.push_back(e);
+				e = std::make_shared<PEvent>();
+			}
+			else if (words[0] == "ENDOBJECT") {
+				for (std::shared_ptr<PEvent> ev : events)
+					b.AddEvent(ev);
+				events.clear();
+				bodies.push_back(std::make_shared<PhysicsBody>(b));
+				b = PhysicsBody();
+			}
+		}
+	}
+	return bodies;
+}
+
+std::string SimFile::Serialize(std::list<std::shared_ptr<PhysicsBody>>& bodies) {
+	std::stringstream data;
+	int i = 0;
+	for (std::shared_ptr<PhysicsBody> body : bodies) {
+		if (i > 0)
+			data << body->BodyData() << "\n";
+		i++;
+	}
+	return data.str();
+}
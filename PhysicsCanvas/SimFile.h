@@ -0,0 +1,17 @@
+#pragma once
+#include "pch.h"
+#include "PhysicsBody.h"
+#include <list>
+#include <string>
+
+namespace PhysicsCanvas {
+	//Reading and writing the text of .psim project files, shared by the editor and the headless runner
+	class SimFile {
+	public:
+		//builds the bodies described by the file, in file order. deviceResources can be null to load the bodies without meshes
+		static std::list<std::shared_ptr<PhysicsBody>> Parse(const std::string& data, const std::shared_ptr<DX::DeviceResources>& deviceResources);
+
+		//the floor is always the first body and isn't written out, since every scene makes its own
+		static std::string Serialize(std::list<std::shared_ptr<PhysicsBody>>& bodies);
+	};
+}
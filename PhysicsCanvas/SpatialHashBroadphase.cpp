@@ -0,0 +1,101 @@
+#include "SpatialHashBroadphase.h"
+#include <algorithm>
+
+using namespace PhysicsCanvas;
+
+void SpatialHashBroadphase::Update(std::list<std::shared_ptr<PhysicsBody>>& bodies) {
+	if (!SyncProxies(bodies)) {
+		//the table is only resized when bodies are added or removed, to the next power of two above twice the body count
+		bucketCount = 16;
+		while (bucketCount < proxies.size() * 2)
+			bucketCount <<= 1;
+		bucketStarts.assign(bucketCount + 1, 0);
+		bucketCursor.assign(bucketCount, 0);
+		isLarge.assign(proxies.size(), false);
+		extents.reserve(proxies.size());
+		large.reserve(proxies.size());
+		entries.reserve(proxies.size() * 8);
+		sorted.reserve(proxies.size() * 8);
+	}
+	RefreshBounds();
+	TuneCellSize();
+
+	pairs.clear();
+	entries.clear();
+	large.clear();
+	for (int i = 0; i < (int)proxies.size(); i++) {
+		Proxy& p = proxies[i];
+		int x0 = CellCoord(p.minP.x), y0 = CellCoord(p.minP.y), z0 = CellCoord(p.minP.z);
+		int x1 = CellCoord(p.maxP.x), y1 = CellCoord(p.maxP.y), z1 = CellCoord(p.maxP.z);
+		long long cells = (long long)(x1 - x0 + 1) * (y1 - y0 + 1) * (z1 - z0 + 1);
+		isLarge[i] = cells > MAX_CELLS_PER_BODY;
+		if (isLarge[i]) {
+			large.push_back(i);
+			continue;
+		}
+		for (int x = x0; x <= x1; x++)
+			for (int y = y0; y <= y1; y++)
+				for (int z = z0; z <= z1; z++)
+					entries.push_back({ x, y, z, i, HashCell(x, y, z) });
+	}
+
+	//counting sort of the entries into their buckets, which is linear in the number of entries
+	std::fill(bucketStarts.begin(), bucketStarts.end(), 0);
+	for (CellEntry& e : entries)
+		bucketStarts[e.bucket + 1]++;
+	for (UINT b = 0; b < bucketCount; b++)
+		bucketStarts[b + 1] += bucketStarts[b];
+	std::copy(bucketStarts.begin(), bucketStarts.end() - 1, bucketCursor.begin());
+	sorted.resize(entries.size());
+	for (CellEntry& e : entries)
+		sorted[bucketCursor[e.bucket]++] = e;
+
+	for (UINT b = 0; b < bucketCount; b++) {
+		for (UINT i = bucketStarts[b]; i < bucketStarts[b + 1]; i++) {
+			CellEntry& e1 = sorted[i];
+			for (UINT j = i + 1; j < bucketStarts[b + 1]; j++) {
+				CellEntry& e2 = sorted[j];
+				//different cells can hash to the same bucket
+				if (e1.cx != e2.cx || e1.cy != e2.cy || e1.cz != e2.cz)
+					continue;
+				Proxy& p1 = proxies[e1.proxy];
+				Proxy& p2 = proxies[e2.proxy];
+				if (!Overlaps(p1, p2))
+					continue;
+				//two bodies can share several cells, so only report the pair from the cell holding the corner of their overlap
+				if (CellCoord(p1.minP.x > p2.minP.x ? p1.minP.x : p2.minP.x) != e1.cx
+					|| CellCoord(p1.minP.y > p2.minP.y ? p1.minP.y : p2.minP.y) != e1.cy
+					|| CellCoord(p1.minP.z > p2.minP.z ? p1.minP.z : p2.minP.z) != e1.cz)
+					continue;
+				pairs.push_back(e1.proxy < e2.proxy ? BodyPair(e1.proxy, e2.proxy) : BodyPair(e2.proxy, e1.proxy));
+			}
+		}
+	}
+
+	for (int l : large) {
+		for (int i = 0; i < (int)proxies.size(); i++) {
+			//pairs of large bodies are only reported from the one with the lower index
+			if (i == l || (isLarge[i] && i < l))
+				continue;
+			if (Overlaps(proxies[l], proxies[i]))
+				pairs.push_back(l < i ? BodyPair(l, i) : BodyPair(i, l));
+		}
+	}
+}
+
+void SpatialHashBroadphase::TuneCellSize() {
+	extents.clear();
+	for (Proxy& p : proxies) {
+		float e = p.maxP.x - p.minP.x;
+		if (p.maxP.y - p.minP.y > e) e = p.maxP.y - p.minP.y;
+		if (p.maxP.z - p.minP.z > e) e = p.maxP.z - p.minP.z;
+		extents.push_back(e);
+	}
+	if (extents.empty())
+		return;
+	//median, so that one huge body (the floor) doesn't blow the cells up
+	std::nth_element(extents.begin(), extents.begin() + extents.size() / 2, extents.end());
+	float median = extents[extents.size() / 2];
+	if (median > 0.01f)
+		cellSize = median;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "pch.h"
+#include "Broadphase.h"
+
+namespace PhysicsCanvas {
+	//Uniform grid broadphase for scenes with lots of similarly sized bodies. Every body is put into a bucket for each grid cell its AABB touches,
+	//and only bodies that share a cell get paired up. The cell size follows the median size of the bodies in the scene.
+	//All of the buckets live in flat arrays that are kept between steps, so once the scene has settled a rebuild does not allocate.
+	class SpatialHashBroadphase : public Broadphase {
+	public:
+		void Update(std::list<std::shared_ptr<PhysicsBody>>& bodies) override;
+
+		Type GetType() override { return SpatialHash; }
+
+		float GetCellSize() { return cellSize; }
+	private:
+		struct CellEntry {
+			int cx, cy, cz;
+			int proxy;
+			UINT bucket;
+		};
+
+		//bodies covering more cells than this (like the floor) are kept out of the grid and checked against everything instead
+		static const int MAX_CELLS_PER_BODY = 64;
+
+		void TuneCellSize();
+
+		int CellCoord(float v) { return (int)floorf(v / cellSize); }
+
+		UINT HashCell(int cx, int cy, int cz) {
+			return (((UINT)cx * 73856093u) ^ ((UINT)cy * 19349663u) ^ ((UINT)cz * 83492791u)) & (bucketCount - 1);
+		}
+
+		float cellSize = 1.0f;
+		UINT bucketCount = 0;
+
+		std::vector<float> extents;			//scratch space for finding the median body size
+		std::vector<CellEntry> entries;		//one per (body, cell) in the order they were found
+		std::vector<CellEntry> sorted;		//the same entries grouped by bucket
+		std::vector<UINT> bucketStarts;		//bucketStarts[b] to bucketStarts[b + 1] is the range of bucket b in sorted
+		std::vector<UINT> bucketCursor;
+		std::vector<int> large;
+		std::vector<bool> isLarge;
+	};
+}
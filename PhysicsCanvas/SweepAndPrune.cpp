@@ -0,0 +1,62 @@
+#include "SweepAndPrune.h"
+#include <algorithm>
+
+using namespace PhysicsCanvas;
+
+void SweepAndPrune::Update(std::list<std::shared_ptr<PhysicsBody>>& bodies) {
+	bool unchanged = SyncProxies(bodies);
+	if (!unchanged) {
+		endpoints.clear();
+		for (int i = 0; i < (int)proxies.size(); i++) {
+			endpoints.push_back({ 0.0f, i, true });
+			endpoints.push_back({ 0.0f, i, false });
+		}
+	}
+
+	RefreshBounds();
+	for (Endpoint& e : endpoints) {
+		e.value = e.isMin ? proxies[e.proxy].minP.x : proxies[e.proxy].maxP.x;
+	}
+
+	if (unchanged) {
+		//insertion sort, which is close to O(n) since the order barely changes between steps
+		for (size_t i = 1; i < endpoints.size(); i++) {
+			Endpoint e = endpoints[i];
+			size_t j = i;
+			while (j > 0 && EndpointLess(e, endpoints[j - 1])) {
+				endpoints[j] = endpoints[j - 1];
+				j--;
+			}
+			endpoints[j] = e;
+		}
+	}
+	else {
+		std::sort(endpoints.begin(), endpoints.end(), EndpointLess);
+	}
+
+	//sweep along x, anything still open when a new box opens overlaps it on x so only y and z need checking
+	pairs.clear();
+	active.clear();
+	for (Endpoint& e : endpoints) {
+		if (e.isMin) {
+			Proxy& p = proxies[e.proxy];
+			for (int other : active) {
+				Proxy& o = proxies[other];
+				if (p.minP.y <= o.maxP.y && p.maxP.y >= o.minP.y
+					&& p.minP.z <= o.maxP.z && p.maxP.z >= o.minP.z) {
+					pairs.push_back(other < e.proxy ? BodyPair(other, e.proxy) : BodyPair(e.proxy, other));
+				}
+			}
+			active.push_back(e.proxy);
+		}
+		else {
+			for (size_t i = 0; i < active.size(); i++) {
+				if (active[i] == e.proxy) {
+					active[i] = active.back();
+					active.pop_back();
+					break;
+				}
+			}
+		}
+	}
+}
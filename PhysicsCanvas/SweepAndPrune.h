@@ -0,0 +1,28 @@
+#pragma once
+#include "pch.h"
+#include "Broadphase.h"
+
+namespace PhysicsCanvas {
+	//Sweep-and-prune broadphase. The min/max ends of every body's AABB are kept in one list sorted along the x axis;
+	//since bodies only move a little each step, the list is nearly sorted already and an insertion sort puts it back in order in close to linear time.
+	class SweepAndPrune : public Broadphase {
+	public:
+		void Update(std::list<std::shared_ptr<PhysicsBody>>& bodies) override;
+
+		Type GetType() override { return SweepPrune; }
+	private:
+		struct Endpoint {
+			float value;
+			int proxy;
+			bool isMin;
+		};
+
+		static bool EndpointLess(const Endpoint& a, const Endpoint& b) {
+			//at equal values put mins first so that touching boxes are still reported
+			return a.value < b.value || (a.value == b.value && a.isMin && !b.isMin);
+		}
+
+		std::vector<Endpoint> endpoints;
+		std::vector<int> active;
+	};
+}
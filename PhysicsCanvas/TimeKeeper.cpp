@@ -0,0 +1,504 @@
+#include "TimeKeeper.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace PhysicsCanvas;
+
+const float TimeKeeper::DEFAULT_ERROR_BOUND = 1e-5f;
+const float TimeKeeper::TIME_RESOLUTION = 1e-6f;
+const float TimeKeeper::DEFAULT_STEP = 0.001f;
+
+static const int FIELDS = TimeKeeper::FIELD_COUNT;
+static const double MAX_STEPS = 4503599627370496.0;	//2^52, past this a value can't be held as a whole number of steps
+
+static void ToValues(const Record& r, double* v) {
+	const DirectX::XMFLOAT3* vecs[4] = { &r.position, &r.rotation, &r.velocity, &r.ang_velocity };
+	v[0] = r.time;
+	for (int i = 0; i < 4; i++) {
+		v[1 + i * 3] = vecs[i]->x;
+		v[2 + i * 3] = vecs[i]->y;
+		v[3 + i * 3] = vecs[i]->z;
+	}
+}
+
+static void FromValues(const double* v, Record& r) {
+	DirectX::XMFLOAT3* vecs[4] = { &r.position, &r.rotation, &r.velocity, &r.ang_velocity };
+	r.time = (float)v[0];
+	for (int i = 0; i < 4; i++) {
+		vecs[i]->x = (float)v[1 + i * 3];
+		vecs[i]->y = (float)v[2 + i * 3];
+		vecs[i]->z = (float)v[3 + i * 3];
+	}
+}
+
+//zigzag keeps small negative numbers small: 0, -1, 1, -2... become 0, 1, 2, 3...
+static uint64_t ZigZag(int64_t n) { return ((uint64_t)n << 1) ^ (uint64_t)(n >> 63); }
+static int64_t UnZigZag(uint64_t n) { return (int64_t)(n >> 1) ^ -(int64_t)(n & 1); }
+
+static void PutVarint(std::vector<uint8_t>& out, uint64_t n) {
+	while (n >= 0x80) {
+		out.push_back((uint8_t)(n | 0x80));
+		n >>= 7;
+	}
+	out.push_back((uint8_t)n);
+}
+
+static uint64_t GetVarint(const uint8_t*& in) {
+	uint64_t n = 0;
+	for (int shift = 0;; shift += 7) {
+		uint8_t byte = *in++;
+		n |= (uint64_t)(byte & 0x7f) << shift;
+		if (!(byte & 0x80))
+			return n;
+	}
+}
+
+//rounds every value to a whole number of steps, the same as compressing it would
+static Record Quantise(const Record& r, double step) {
+	double v[FIELDS];
+	ToValues(r, v);
+	for (int f = 0; f < FIELDS; f++) {
+		double q = v[f] / (f == 0 ? TimeKeeper::TIME_RESOLUTION : step);
+		if (fabs(q) < MAX_STEPS)
+			v[f] = llround(q) * (f == 0 ? TimeKeeper::TIME_RESOLUTION : step);
+	}
+	Record out;
+	FromValues(v, out);
+	return out;
+}
+
+//carries a value on at its rate for dt, with the rate changing at change, the way bodies step: each step moves them by the rate
+//at the end of it, so over dt they get change*step*dt further than s = ut + 1/2 at^2 would take them
+static void Carry(const DirectX::XMFLOAT3& value, const DirectX::XMFLOAT3& rate, const DirectX::XMFLOAT3& change, float dt,
+	float step, DirectX::XMFLOAT3& outValue, DirectX::XMFLOAT3& outRate) {
+	float t2 = 0.5f * dt * dt + step * dt;
+	outValue = DirectX::XMFLOAT3(value.x + rate.x * dt + change.x * t2, value.y + rate.y * dt + change.y * t2,
+		value.z + rate.z * dt + change.z * t2);
+	outRate = DirectX::XMFLOAT3(rate.x + change.x * dt, rate.y + change.y * dt, rate.z + change.z * dt);
+}
+
+//works out the record at time from the last one or two before it
+static Record Extrapolate(const Record* from, int count, float time, float step) {
+	const Record& last = from[count - 1];
+	DirectX::XMFLOAT3 accel(0, 0, 0), alpha(0, 0, 0);
+	float gap = count == 2 ? last.time - from[0].time : 0;
+	if (gap > 0) {
+		accel = DirectX::XMFLOAT3((last.velocity.x - from[0].velocity.x) / gap, (last.velocity.y - from[0].velocity.y) / gap,
+			(last.velocity.z - from[0].velocity.z) / gap);
+		alpha = DirectX::XMFLOAT3((last.ang_velocity.x - from[0].ang_velocity.x) / gap, (last.ang_velocity.y - from[0].ang_velocity.y) / gap,
+			(last.ang_velocity.z - from[0].ang_velocity.z) / gap);
+	}
+	Record out;
+	out.time = time;
+	Carry(last.position, last.velocity, accel, time - last.time, step, out.position, out.velocity);
+	Carry(last.rotation, last.ang_velocity, alpha, time - last.time, step, out.rotation, out.ang_velocity);
+	return out;
+}
+
+void TimeKeeper::RecordData(Record data, bool keyframe) {
+	bool keep = keyframe || tolerance <= 0 || !Predictable(data);
+	if (!latestKept) {
+		if (keep) {
+			//the step before is kept too, so whatever this one changes is between two kept records rather than spread over the gap
+			Keep(latest);
+			keep = keyframe || tolerance <= 0 || !Predictable(data);
+		}
+		else {
+			dense = false;
+		}
+	}
+	if (keep)
+		Keep(data);
+	latest = data;
+	latestKept = keep;
+	lastTime = data.time;
+}
+
+void TimeKeeper::Keep(Record data) {
+	//kept records are rounded now rather than when they're compressed, so steps are worked out from the same values when
+	//they're recorded as when they're retrieved
+	if (tolerance > 0 && errorBound > 0)
+		data = Quantise(data, errorBound * 2);
+	//the full block is only compressed once the next record arrives, so the newest record is always held exactly
+	if (openCount == BLOCK_SIZE)
+		SealBlock();
+	double v[FIELDS];
+	ToValues(data, v);
+	for (int f = 0; f < FIELDS; f++)
+		open[f][openCount] = (float)v[f];
+	openCount++;
+	anchors[0] = anchors[1];
+	anchors[1] = data;
+	anchorCount = anchorCount < 2 ? anchorCount + 1 : 2;
+}
+
+bool TimeKeeper::Predictable(const Record& data) {
+	if (anchorCount == 0)
+		return false;
+	Record guess = Extrapolate(anchorCount == 2 ? anchors : anchors + 1, anchorCount, data.time, step);
+	double v[FIELDS], g[FIELDS];
+	ToValues(data, v);
+	ToValues(guess, g);
+	for (int f = 1; f < FIELDS; f++) {
+		if (!(fabs(v[f] - g[f]) <= tolerance))		//also catches NaN
+			return false;
+	}
+	return true;
+}
+
+Record TimeKeeper::Retrieve(float timestamp) {
+	if (KeptCount() == 0)	return NULL_RECORD;
+
+	if (timestamp > lastTime || timestamp < startTime) {
+		return NULL_RECORD;
+	}
+
+	if (IndexOf(timestamp) == 0)
+		return initial;
+	if (!dense)
+		return Reconstruct(timestamp);
+	size_t index = IndexOf(timestamp);
+	if (index >= KeptCount())
+		return NULL_RECORD;
+	return Kept(index);
+}
+
+Record TimeKeeper::Sample(float time) {
+	if (KeptCount() == 0 || time > lastTime || time < startTime)
+		return NULL_RECORD;
+	double position = (time - (double)startTime) / step;
+	size_t index = (size_t)position;
+	if (index + 1 >= GetCount())
+		return At(GetCount() - 1);
+	double a[FIELDS], b[FIELDS];
+	ToValues(At(index), a);
+	ToValues(At(index + 1), b);
+	double along = position - index;
+	for (int f = 0; f < FIELDS; f++)
+		a[f] += (b[f] - a[f]) * along;
+	Record r;
+	FromValues(a, r);
+	r.time = time;
+	return r;
+}
+
+Record TimeKeeper::Reconstruct(float time) {
+	float halfStep = step / 2;
+	if (time >= lastTime - halfStep)
+		return latest;
+	//the first record is always kept at time 0, so there's always one at or before time
+	size_t index = KeptBefore(time + halfStep) - 1;
+	Record from[2];
+	int count = 0;
+	if (index > 0)
+		from[count++] = Kept(index - 1);
+	from[count++] = Kept(index);
+	if (from[count - 1].time > time - halfStep)
+		return from[count - 1];
+	return Extrapolate(from, count, time, step);
+}
+
+Record TimeKeeper::At(size_t index) {
+	if (dense)
+		return Kept(index);
+	float time = TimeOf(index);
+	return Reconstruct(time < lastTime ? time : lastTime);
+}
+
+Record TimeKeeper::Kept(size_t index) {
+	const Columns& columns = BlockColumns(index / BLOCK_SIZE);
+	double v[FIELDS];
+	for (int f = 0; f < FIELDS; f++)
+		v[f] = columns[f][index % BLOCK_SIZE];
+	Record r;
+	FromValues(v, r);
+	return r;
+}
+
+TimeKeeper::Span TimeKeeper::ReadColumn(Field field, size_t first, size_t count, std::vector<float>& out) {
+	size_t total = GetCount();
+	first = first < total ? first : total;
+	count = count < total - first ? count : total - first;
+	out.resize(count);
+	if (!dense) {
+		for (size_t i = 0; i < count; i++) {
+			double v[FIELDS];
+			ToValues(At(first + i), v);
+			out[i] = (float)v[field];
+		}
+		return { out.data(), count };
+	}
+
+	for (size_t i = 0; i < count;) {
+		size_t block = (first + i) / BLOCK_SIZE;
+		size_t offset = (first + i) % BLOCK_SIZE;
+		size_t n = BLOCK_SIZE - offset < count - i ? BLOCK_SIZE - offset : count - i;
+		//the cache is only read, never filled, so several threads can read columns at once
+		int cached = cachedBlocks[0] == (long long)block ? 0 : cachedBlocks[1] == (long long)block ? 1 : -1;
+		if (block == blocks.size()) {
+			memcpy(&out[i], open[field] + offset, n * sizeof(float));
+		}
+		else if (cached >= 0) {
+			memcpy(&out[i], cache[cached][field] + offset, n * sizeof(float));
+		}
+		else if (n == BLOCK_SIZE) {
+			DecodeColumn(block, field, &out[i]);
+		}
+		else {
+			float column[BLOCK_SIZE];
+			DecodeColumn(block, field, column);
+			memcpy(&out[i], column + offset, n * sizeof(float));
+		}
+		i += n;
+	}
+	return { out.data(), count };
+}
+
+const TimeKeeper::Columns& TimeKeeper::BlockColumns(size_t block) {
+	if (block == blocks.size())
+		return open;
+	for (int c = 0; c < 2; c++) {
+		if (cachedBlocks[c] == (long long)block) {
+			lastCache = c;
+			return cache[c];
+		}
+	}
+	//replace whichever was used longest ago
+	int c = 1 - lastCache;
+	DecodeBlock(block, cache[c]);
+	cachedBlocks[c] = block;
+	lastCache = c;
+	return cache[c];
+}
+
+size_t TimeKeeper::KeptBefore(float time) {
+	//everything before time is in the blocks that start before it, so only the last of those needs searching
+	size_t block = std::lower_bound(blockTimes.begin(), blockTimes.end(), time) - blockTimes.begin();
+	size_t count = BLOCK_SIZE;
+	if (block == blocks.size() && openCount > 0 && open[Time][0] < time)
+		count = openCount;
+	else if (block == 0)
+		return 0;
+	else
+		block--;
+	const float* times = BlockColumns(block)[Time];
+	return block * BLOCK_SIZE + (std::lower_bound(times, times + count, time) - times);
+}
+
+void TimeKeeper::Wipe(Record first) {
+	blocks.clear();
+	blockTimes.clear();
+	openCount = 0;
+	oldHistories.clear();
+	cachedBlocks[0] = cachedBlocks[1] = -1;
+	anchorCount = 0;
+	wipedAt = ++revision;
+	cuts.clear();
+	dense = true;
+	step = nextStep;
+	startTime = first.time;
+	Keep(first);
+	initial = first;
+	latest = first;
+	latestKept = true;
+	lastTime = first.time;
+}
+
+void TimeKeeper::Truncate(Record latest) {
+	size_t keep = KeptBefore(latest.time - step / 2);
+	bool wasKept = keep < KeptCount() && Kept(keep).time < latest.time + step / 2;
+	size_t sealed = blocks.size() * BLOCK_SIZE;
+	if (keep >= sealed) {
+		openCount = keep - sealed;
+	}
+	else {
+		//the block the cut falls in becomes the open one again
+		size_t block = keep / BLOCK_SIZE;
+		DecodeBlock(block, open);
+		openCount = keep % BLOCK_SIZE;
+		blocks.resize(block);
+		blockTimes.resize(block);
+		cachedBlocks[0] = cachedBlocks[1] = -1;
+	}
+	//carry on from what's left as if nothing after the cut had been recorded, so simulating again keeps the same steps
+	anchorCount = 0;
+	for (size_t i = keep > 2 ? keep - 2 : 0; i < keep; i++)
+		anchors[anchorCount++] = Kept(i);
+	dense = keep == IndexOf(latest.time);
+	latestKept = wasKept || tolerance <= 0 || !Predictable(latest);
+	if (latestKept)
+		Keep(latest);
+	this->latest = latest;
+	if (IndexOf(latest.time) == 0)
+		initial = latest;
+	lastTime = latest.time;
+	revision++;
+	cuts.push_back(IndexOf(latest.time));
+}
+
+size_t TimeKeeper::UnchangedSince(uint32_t since) {
+	if (since < wipedAt)
+		return 0;
+	size_t unchanged = GetCount();
+	for (size_t i = since - wipedAt; i < cuts.size(); i++)
+		unchanged = cuts[i] < unchanged ? cuts[i] : unchanged;
+	return unchanged;
+}
+
+size_t TimeKeeper::StoredBytes() {
+	size_t bytes = sizeof(open) + blocks.capacity() * sizeof(Block) + blockTimes.capacity() * sizeof(float);
+	for (Block& b : blocks)
+		bytes += b.data.capacity();
+	return bytes;
+}
+
+void TimeKeeper::SetHistoryFile(std::shared_ptr<HistoryFile> file) {
+	if (history == file)
+		return;
+	if (history)
+		oldHistories.push_back(history);
+	history = file;
+	if (history)
+		historyOwner = history->NewOwner();
+}
+
+void TimeKeeper::SealBlock() {
+	Block block;
+	block.stored = nullptr;
+	block.step = errorBound * 2;	//rounding to the nearest step is off by at most half of it
+
+	//quantise every value, falling back to plain columns if any can't be held as a whole number of steps
+	static const int N = BLOCK_SIZE;
+	int64_t steps[FIELDS][N];
+	for (int f = 0; f < FIELDS && block.step > 0; f++) {
+		double step = f == 0 ? TIME_RESOLUTION : block.step;
+		for (int i = 0; i < N; i++) {
+			double q = open[f][i] / step;
+			if (!(fabs(q) < MAX_STEPS)) {	//also catches NaN
+				block.step = 0;
+				break;
+			}
+			steps[f][i] = llround(q);
+		}
+	}
+
+	if (block.step <= 0) {
+		block.step = 0;
+		block.data.resize(sizeof(open));
+		memcpy(block.data.data(), open, sizeof(open));
+	}
+	else {
+		//encoded into a buffer kept between blocks, then copied out at its final size, so sealing a block only allocates once
+		encoded.clear();
+		for (int f = 0; f < FIELDS; f++) {
+			//the first two values are stored whole, the rest as how far they are off the line through the two before
+			PutVarint(encoded, ZigZag(steps[f][0]));
+			PutVarint(encoded, ZigZag(steps[f][1] - steps[f][0]));
+			uint64_t residuals[N];
+			uint64_t largest = 0;
+			for (int i = 2; i < N; i++) {
+				residuals[i] = ZigZag(steps[f][i] - (2 * steps[f][i - 1] - steps[f][i - 2]));
+				largest |= residuals[i];
+			}
+			int width = 0;
+			while (width < 64 && (largest >> width) != 0)
+				width++;
+			encoded.push_back((uint8_t)width);
+
+			uint64_t buffer = 0;
+			int bits = 0;
+			for (int i = 2; i < N && width > 0; i++) {
+				//write the residual a byte at a time, wide ones might not fit in the buffer alongside what's left in it
+				uint64_t r = residuals[i];
+				for (int left = width; left > 0;) {
+					int take = left < 8 ? left : 8;
+					buffer |= (r & ((1ull << take) - 1)) << bits;
+					bits += take;
+					r >>= take;
+					left -= take;
+					while (bits >= 8) {
+						encoded.push_back((uint8_t)buffer);
+						buffer >>= 8;
+						bits -= 8;
+					}
+				}
+			}
+			if (bits > 0)
+				encoded.push_back((uint8_t)buffer);
+		}
+	}
+	const std::vector<uint8_t>& bytes = block.step > 0 ? encoded : block.data;
+	if (history)
+		block.stored = history->Append(historyOwner, (uint32_t)blocks.size(), block.step, bytes.data(), bytes.size());
+	if (block.stored)
+		block.data = std::vector<uint8_t>();
+	else if (block.step > 0)
+		block.data.assign(encoded.begin(), encoded.end());
+	blocks.push_back(std::move(block));
+	blockTimes.push_back(open[Time][0]);
+	openCount = 0;
+}
+
+//decodes one field's values from a compressed block, returning where the next field starts
+static const uint8_t* DecodeField(const uint8_t* in, double step, float* out) {
+	static const int N = TimeKeeper::BLOCK_SIZE;
+	int64_t prev2 = UnZigZag(GetVarint(in));
+	int64_t prev = prev2 + UnZigZag(GetVarint(in));
+	out[0] = (float)(prev2 * step);
+	out[1] = (float)(prev * step);
+	int width = *in++;
+
+	uint64_t buffer = 0;
+	int bits = 0;
+	for (int i = 2; i < N; i++) {
+		uint64_t r = 0;
+		for (int got = 0; got < width;) {
+			if (bits == 0) {
+				buffer = *in++;
+				bits = 8;
+			}
+			int take = width - got < bits ? width - got : bits;
+			r |= (buffer & ((1ull << take) - 1)) << got;
+			buffer >>= take;
+			bits -= take;
+			got += take;
+		}
+		int64_t current = 2 * prev - prev2 + UnZigZag(r);
+		out[i] = (float)(current * step);
+		prev2 = prev;
+		prev = current;
+	}
+	return in;
+}
+
+//steps over a field in a compressed block without decoding it
+static const uint8_t* SkipField(const uint8_t* in) {
+	GetVarint(in);
+	GetVarint(in);
+	int width = *in++;
+	return in + (width * (TimeKeeper::BLOCK_SIZE - 2) + 7) / 8;
+}
+
+void TimeKeeper::DecodeBlock(size_t index, Columns& out) {
+	const Block& block = blocks[index];
+	if (block.step == 0) {
+		memcpy(out, block.Bytes(), sizeof(Columns));
+		return;
+	}
+	const uint8_t* in = block.Bytes();
+	for (int f = 0; f < FIELDS; f++)
+		in = DecodeField(in, f == 0 ? TIME_RESOLUTION : block.step, out[f]);
+}
+
+void TimeKeeper::DecodeColumn(size_t index, Field field, float* out) {
+	const Block& block = blocks[index];
+	if (block.step == 0) {
+		memcpy(out, block.Bytes() + field * BLOCK_SIZE * sizeof(float), BLOCK_SIZE * sizeof(float));
+		return;
+	}
+	const uint8_t* in = block.Bytes();
+	for (int f = 0; f < field; f++)
+		in = SkipField(in);
+	DecodeField(in, field == Time ? TIME_RESOLUTION : block.step, out);
+}
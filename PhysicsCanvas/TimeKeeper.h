@@ -1,6 +1,9 @@
 #pragma once
 #include "pch.h"
-#include "..\Common\DirectXHelper.h"
+#include "HistoryFile.h"
+#include <cmath>
+#include <cstdint>
+#include <vector>
 
 namespace PhysicsCanvas {
 	struct Record {
@@ -29,32 +32,189 @@ namespace PhysicsCanvas {
 	};
 	const Record NULL_RECORD = { -1, DirectX::XMFLOAT3(), DirectX::XMFLOAT3(), DirectX::XMFLOAT3(), DirectX::XMFLOAT3() };
 
+	//Keeps a record of a body for every step, which are all the same length of time apart from the first one. Records are kept in blocks of BLOCK_SIZE, each field in a column of its own, so
+	//reading one field for many steps doesn't have to go through the others. The newest block is kept as plain values and
+	//the older ones compressed: every value is rounded to within the error bound, then stored as its difference from a
+	//straight line through the two values before it, bit-packed at the smallest width that fits the whole block.
+	//Each block decodes on its own, so retrieving any time only ever decodes one block. With a history file, the compressed
+	//blocks go into the file instead of memory.
+	//With a recording tolerance, a step is only kept if it can't be worked out to within the tolerance from the two kept
+	//before it, by carrying on their velocities and the acceleration between them. Steps in between are worked out the same
+	//way when they're retrieved, so a body at rest or flying freely only needs a record every so often
 	class TimeKeeper {
 	public:
-		void RecordData(float timestamp, DirectX::XMFLOAT3 pos, DirectX::XMFLOAT3 rot, DirectX::XMFLOAT3 vel, DirectX::XMFLOAT3 ang_vel) {
+		static const int BLOCK_SIZE = 64;
+
+		//the columns, in the same order as the values in a Record
+		enum Field { Time, PositionX, PositionY, PositionZ, RotationX, RotationY, RotationZ, VelocityX, VelocityY, VelocityZ,
+			AngVelocityX, AngVelocityY, AngVelocityZ, FIELD_COUNT };
+
+		//values of one field one after another, so they can go straight to a plot or a loop the compiler can vectorise
+		struct Span {
+			const float* data;
+			size_t size;
+			const float* begin() const { return data; }
+			const float* end() const { return data + size; }
+			float operator[](size_t i) const { return data[i]; }
+		};
+		static const float DEFAULT_ERROR_BOUND;	//in m, rad, m/s and rad/s
+		static const float TIME_RESOLUTION;		//times are always kept to within this, whatever the error bound
+		static const float DEFAULT_STEP;		//1ms, the same as the simulation's
+
+		TimeKeeper() : errorBound(DEFAULT_ERROR_BOUND), tolerance(0), step(DEFAULT_STEP), nextStep(DEFAULT_STEP), startTime(0),
+			historyOwner(0), openCount(0), lastTime(0), latestKept(true), dense(true),
+			anchorCount(0), revision(0), wipedAt(0), cachedBlocks{ -1, -1 }, lastCache(0) {}
+
+		//every record in order, each block decoded as it's reached rather than the whole history being copied out
+		class RecordRange {
+		public:
+			class Iterator {
+			public:
+				Iterator(TimeKeeper* keeper, size_t index) : keeper(keeper), index(index) {}
+				Record operator*() { return keeper->At(index); }
+				Iterator& operator++() { index++; return *this; }
+				bool operator!=(const Iterator& other) { return index != other.index; }
+			private:
+				TimeKeeper* keeper;
+				size_t index;
+			};
+
+			RecordRange(TimeKeeper* keeper) : keeper(keeper) {}
+			Iterator begin() { return Iterator(keeper, 0); }
+			Iterator end() { return Iterator(keeper, keeper->GetCount()); }
+			size_t size() { return keeper->GetCount(); }
+			Record operator[](size_t index) { return keeper->At(index); }
+		private:
+			TimeKeeper* keeper;
+		};
+
+		//a keyframe is always kept, along with the step before it, e.g. where a force starts or a collision happens
+		void RecordData(float timestamp, DirectX::XMFLOAT3 pos, DirectX::XMFLOAT3 rot, DirectX::XMFLOAT3 vel, DirectX::XMFLOAT3 ang_vel, bool keyframe = false) {
 			Record data = { timestamp, pos, rot, vel, ang_vel };
-			records.push_back(data);
-		}
-		void RecordData(Record data) {
-			records.push_back(data);
-		}
-		Record Retrieve(float timestamp) {
-			if (records.size() == 0)	return NULL_RECORD;
-			
-			if (timestamp > records[records.size() - 1].time || timestamp < 0) {
-				return NULL_RECORD;
-			}
-			
-			return records[timestamp * 1000];
+			RecordData(data, keyframe);
 		}
-		
-		void Wipe(Record initial) {
-			records.clear();
-			records.push_back(initial);
+		void RecordData(Record data, bool keyframe = false);
+
+		//the record for the step nearest timestamp. The first and newest records always come back exactly as they were
+		//recorded, the rest to within the error bound and tolerance. The first is what a scene is saved with, so saving and
+		//loading it again doesn't move anything
+		Record Retrieve(float timestamp);
+
+		//the state at time, in between the steps either side of it, changing steadily from one to the other
+		Record Sample(float time);
+
+		//starts the history again from initial, with its steps from then on SetStep() apart
+		void Wipe(Record initial);
+
+		//drops everything recorded after latest, which replaces the record at its time
+		void Truncate(Record latest);
+
+		RecordRange GetRecords() { return RecordRange(this); }
+
+		//the record from step index, from 0 to GetCount()
+		Record At(size_t index);
+
+		//field for count steps from step first, or up to the last step recorded, read into out. Only field's own values are
+		//decoded unless some steps weren't kept, which have to be worked out from whole records.
+		//While every step is kept and nothing is being recorded, several threads can read columns at once
+		Span ReadColumn(Field field, size_t first, size_t count, std::vector<float>& out);
+
+		//every step since the last Wipe() has been kept
+		bool AllKept() { return dense; }
+
+		//how far apart the steps recorded after the next Wipe() are, in s
+		void SetStep(float s) { nextStep = s; }
+		float GetStep() { return step; }
+
+		//the time of the first step, where the history was last wiped
+		float GetStartTime() { return startTime; }
+
+		//the step nearest time. Worked out in double precision, so a time a whole number of steps in comes back as that step
+		//rather than the one before however far into the history it is
+		size_t IndexOf(float time) {
+			double index = floor((time - (double)startTime) / step + 0.5);
+			return index > 0 ? (size_t)index : 0;
 		}
+		float TimeOf(size_t index) { return (float)(startTime + index * (double)step); }
+
+		//how far a stored value may be from the recorded one, only applies to blocks compressed after it's set. 0 keeps every value exactly
+		void SetErrorBound(float bound) { errorBound = bound; }
+		float GetErrorBound() { return errorBound; }
+
+		//how far a step that isn't kept may be from what it's worked out to be. 0 keeps every step
+		void SetRecordingTolerance(float t) { tolerance = t; }
+		float GetRecordingTolerance() { return tolerance; }
+
+		//the number of steps recorded, whether or not they were all kept
+		size_t GetCount() { return dense ? KeptCount() : IndexOf(lastTime) + 1; }
+
+		//the number of records actually kept
+		size_t KeptCount() { return blocks.size() * BLOCK_SIZE + openCount; }
+
+		//the memory taken up by the records, not counting any that are in a history file
+		size_t StoredBytes();
 
-		std::vector<Record> GetRecords() { return records; }
+		//blocks compressed from now on go into file, or stay in memory if it's null
+		void SetHistoryFile(std::shared_ptr<HistoryFile> file);
+
+		//goes up every time the history is wiped or truncated, so anything worked out from it can tell when it has to be redone
+		uint32_t GetRevision() { return revision; }
+
+		//how many steps at the start of the history are still the same as they were at revision since
+		size_t UnchangedSince(uint32_t since);
+
+		//how many steps at the start of the history will keep coming back the same unless it's truncated. The newer ones can
+		//still change slightly when their block is compressed, or when they weren't kept and there are later steps to work
+		//them out from
+		size_t SettledCount() { return dense ? blocks.size() * BLOCK_SIZE : GetCount() - 1; }
 	private:
-		std::vector<Record> records;
+		typedef float Columns[FIELD_COUNT][BLOCK_SIZE];
+		struct Block {
+			float step;						//values are whole multiples of this, 0 if the block is stored as plain records
+			std::vector<uint8_t> data;
+			const uint8_t* stored;			//where the block is in a history file, if it's there rather than in data
+			const uint8_t* Bytes() const { return stored ? stored : data.data(); }
+		};
+		void Keep(Record data);
+		bool Predictable(const Record& data);
+		Record Reconstruct(float time);
+		Record Kept(size_t index);
+		const Columns& BlockColumns(size_t block);
+		size_t KeptBefore(float time);
+		void SealBlock();
+		void DecodeBlock(size_t index, Columns& out);
+		void DecodeColumn(size_t index, Field field, float* out);
+
+		float errorBound;
+		float tolerance;
+		float step;
+		float nextStep;
+		float startTime;
+		std::shared_ptr<HistoryFile> history;
+		uint32_t historyOwner;
+		std::vector<std::shared_ptr<HistoryFile>> oldHistories;	//kept open while any of the blocks are still in them
+		std::vector<Block> blocks;
+		std::vector<float> blockTimes;	//the time of each block's first record, to search for a time without decoding them
+		Columns open;					//the newest records kept, which haven't filled a block yet
+		std::vector<uint8_t> encoded;	//a block as it's being compressed
+		size_t openCount;
+		float lastTime;
+
+		Record latest;					//the last step recorded, exactly, whether or not it is kept
+		Record initial = NULL_RECORD;	//the first step, exactly, whatever the error bound and tolerance
+		bool latestKept;
+		bool dense;						//every step since the last Wipe() has been kept, so a step's record is at its own index
+		Record anchors[2];				//the last two records kept, as they are stored, which the next steps are worked out from
+		int anchorCount;
+
+		uint32_t revision;
+		uint32_t wipedAt;				//the revision of the last Wipe()
+		std::vector<size_t> cuts;		//the step each Truncate() since then cut the history at
+
+		//the last two blocks decoded, so stepping through time decodes each block once, even when working out the steps
+		//after a block's first record needs the last record of the block before
+		Columns cache[2];
+		long long cachedBlocks[2];
+		int lastCache;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+#include "pch.h"
+#include <atomic>
+
+namespace PhysicsCanvas {
+	//Hands the latest version of a value from one writer thread to one reader thread without either of them waiting.
+	//The writer fills Back() and publishes it, the reader always gets the most recently published value. Each side owns
+	//one of the three slots and the third is passed between them with an atomic swap, so neither ever touches the other's slot.
+	template <typename T>
+	class TripleBuffer {
+	public:
+		TripleBuffer() : back(0), middle(1), front(2) {}
+
+		//writer only: the slot to fill in next
+		T& Back() { return slots[back]; }
+
+		//writer only: makes Back() the latest value and gives the writer a different slot to fill
+		void Publish() {
+			back = middle.exchange(back | FRESH) & INDEX;
+		}
+
+		//reader only: the latest published value, which stays valid until the next call. The reader has it to itself until
+		//then, so it can bring parts of it up to date as it uses them
+		T& Read() {
+			if (middle.load() & FRESH)
+				front = middle.exchange(front) & INDEX;
+			return slots[front];
+		}
+	private:
+		static const int INDEX = 3;
+		static const int FRESH = 4;	//set on the middle slot when it holds a value the reader hasn't taken yet
+
+		T slots[3];
+		int back;
+		std::atomic<int> middle;
+		int front;
+	};
+}
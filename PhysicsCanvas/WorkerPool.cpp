@@ -0,0 +1,80 @@
+#include "WorkerPool.h"
+
+using namespace PhysicsCanvas;
+
+WorkerPool::WorkerPool(unsigned int threads)
+	: threadCount(threads), currentJob(nullptr), jobCount(0), generation(0), pending(0), stopping(false) {
+	if (threadCount == 0)
+		threadCount = std::thread::hardware_concurrency();
+	if (threadCount == 0)
+		threadCount = 1;
+	for (unsigned int i = 1; i < threadCount; i++) {
+		workers.push_back(std::thread(&WorkerPool::WorkerLoop, this, i));
+	}
+}
+
+WorkerPool::~WorkerPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (std::thread& t : workers)
+		t.join();
+}
+
+void WorkerPool::ParallelFor(int count, const std::function<void(int, int)>& job) {
+	unsigned int threads = GetThreadCount();
+	if (threads == 1 || count < 2) {
+		if (count > 0)
+			job(0, count);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		currentJob = &job;
+		jobCount = count;
+		pending = threadCount - 1;
+		generation++;
+	}
+	wake.notify_all();
+
+	//the first chunk is done on this thread
+	int end = count / (int)threads;
+	if (end > 0)
+		job(0, end);
+
+	std::unique_lock<std::mutex> lock(mutex);
+	done.wait(lock, [this] { return pending == 0; });
+	currentJob = nullptr;
+}
+
+void WorkerPool::WorkerLoop(unsigned int index) {
+	unsigned long long seen = 0;
+	while (true) {
+		const std::function<void(int, int)>* job;
+		int count;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [this, seen] { return stopping || generation != seen; });
+			if (stopping)
+				return;
+			seen = generation;
+			job = currentJob;
+			count = jobCount;
+		}
+
+		int begin = (int)((long long)count * index / threadCount);
+		int end = (int)((long long)count * (index + 1) / threadCount);
+		if (begin < end)
+			(*job)(begin, end);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			pending--;
+			if (pending == 0)
+				done.notify_one();
+		}
+	}
+}
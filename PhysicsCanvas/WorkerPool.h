@@ -0,0 +1,38 @@
+#pragma once
+#include "pch.h"
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace PhysicsCanvas {
+	//A fixed set of threads that share out a range of work between them. Each thread always gets the same slice of the range,
+	//and the calling thread takes the first slice itself, so a pool with one thread just runs everything inline.
+	class WorkerPool {
+	public:
+		//threadCount includes the calling thread, 0 means one per hardware thread
+		WorkerPool(unsigned int threads = 0);
+
+		~WorkerPool();
+
+		unsigned int GetThreadCount() { return threadCount; }
+
+		//calls job(begin, end) on contiguous chunks covering [0, count) and returns once all of them are done
+		void ParallelFor(int count, const std::function<void(int, int)>& job);
+	private:
+		void WorkerLoop(unsigned int index);
+
+		unsigned int threadCount;		//set before any worker starts, so it's safe for them to read
+		std::vector<std::thread> workers;
+		std::mutex mutex;
+		std::condition_variable wake;
+		std::condition_variable done;
+
+		const std::function<void(int, int)>* currentJob;
+		int jobCount;
+		unsigned long long generation;	//goes up by one for each ParallelFor so the workers can tell there's new work
+		unsigned int pending;			//workers that haven't finished their chunk of the current job
+		bool stopping;
+	};
+}
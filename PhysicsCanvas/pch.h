@@ -1,5 +1,15 @@
 ﻿#pragma once
 
+#ifdef PHYSICSCANVAS_HEADLESS
+//just the physics, e.g. for the headless runner on Linux, with DirectXMath but nothing else from Windows
+#include <DirectXMath.h>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+typedef unsigned int UINT;
+#else
 #include <wrl.h>
 #include <wrl/client.h>
 #include <dxgi1_4.h>
@@ -17,4 +27,5 @@
 #define NOMINMAX
 #define WIN32_LEAN_AND_MEAN
 #include <sdkddkver.h>
-#define __cplusplus_winrt
\ No newline at end of file
+#define __cplusplus_winrt
+#endif